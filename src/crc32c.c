@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * CRC32C (Castagnoli polynomial, as in iSCSI and SCTP).
+ *
+ * On x86-64, the SSE4.2 crc32 instruction is used if the CPU supports
+ * it (checked at run time); otherwise, the table-driven implementation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "crc32c.h"
+#include "utils.h"
+
+#define	CRC32C_POLY	0x82f63b78U	/* reversed 0x1edc6f41 */
+
+static uint32_t		crc32c_table[256];
+
+static void __attribute__((constructor))
+crc32c_init(void)
+{
+	for (unsigned i = 0; i < 256; i++) {
+		uint32_t crc = i;
+
+		for (unsigned j = 0; j < 8; j++) {
+			crc = (crc >> 1) ^ (CRC32C_POLY & -(crc & 1));
+		}
+		crc32c_table[i] = crc;
+	}
+}
+
+static uint32_t
+crc32c_sw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	while (len--) {
+		crc = (crc >> 8) ^ crc32c_table[(crc ^ *p++) & 0xff];
+	}
+	return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+
+#define	CRC32C_HW
+
+static uint32_t __attribute__((target("sse4.2")))
+crc32c_hw(uint32_t crc, const uint8_t *p, size_t len)
+{
+	uint64_t crc64 = crc;
+
+	while (len >= sizeof(uint64_t)) {
+		uint64_t val;
+
+		memcpy(&val, p, sizeof(uint64_t));
+		crc64 = _mm_crc32_u64(crc64, val);
+		p += sizeof(uint64_t);
+		len -= sizeof(uint64_t);
+	}
+	crc = (uint32_t)crc64;
+	while (len--) {
+		crc = _mm_crc32_u8(crc, *p++);
+	}
+	return crc;
+}
+#endif
+
+/*
+ * ringbuf_crc32c: compute the CRC32C of the buffer, continuing from the given
+ * value (zero to start).
+ */
+uint32_t
+ringbuf_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	crc = ~crc;
+#ifdef CRC32C_HW
+	if (__predict_true(__builtin_cpu_supports("sse4.2"))) {
+		return ~crc32c_hw(crc, buf, len);
+	}
+#endif
+	return ~crc32c_sw(crc, buf, len);
+}
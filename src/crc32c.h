@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _CRC32C_H_
+#define _CRC32C_H_
+
+#include <inttypes.h>
+
+__BEGIN_DECLS
+
+uint32_t	ringbuf_crc32c(uint32_t, const void *, size_t);
+
+__END_DECLS
+
+#endif
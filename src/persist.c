@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Write-back of the memory ranges to the persistent storage.
+ *
+ * On a DAX mapping (persistent memory), the stores become durable once
+ * the cache lines are written back: clwb (keeps the line in the cache)
+ * or clflushopt, followed by sfence; clflush is the fallback.  The
+ * instruction is selected at run time.  Only x86-64 is supported.  On an
+ * ordinary file mapping, msync(2) writes back the pages.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include "ringbuf.h"
+#include "persist.h"
+#include "utils.h"
+
+static uintptr_t	persist_pagemask;
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define	PERSIST_X86
+
+static enum { FLUSH_CLFLUSH, FLUSH_CLFLUSHOPT, FLUSH_CLWB } persist_insn;
+
+static void __attribute__((target("clwb")))
+flush_clwb(const uint8_t *p, const uint8_t *end)
+{
+	for (; p < end; p += CACHE_LINE_SIZE) {
+		_mm_clwb((void *)(uintptr_t)p);
+	}
+}
+
+static void __attribute__((target("clflushopt")))
+flush_clflushopt(const uint8_t *p, const uint8_t *end)
+{
+	for (; p < end; p += CACHE_LINE_SIZE) {
+		_mm_clflushopt((void *)(uintptr_t)p);
+	}
+}
+
+static void
+flush_clflush(const uint8_t *p, const uint8_t *end)
+{
+	for (; p < end; p += CACHE_LINE_SIZE) {
+		_mm_clflush(p);
+	}
+}
+#endif
+
+static void __attribute__((constructor))
+persist_init(void)
+{
+#ifdef PERSIST_X86
+	unsigned eax, ebx, ecx, edx;
+
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+		if (ebx & bit_CLWB) {
+			persist_insn = FLUSH_CLWB;
+		} else if (ebx & bit_CLFLUSHOPT) {
+			persist_insn = FLUSH_CLFLUSHOPT;
+		}
+	}
+#endif
+	persist_pagemask = (uintptr_t)sysconf(_SC_PAGESIZE) - 1;
+}
+
+#ifdef PERSIST_X86
+/*
+ * persist_flush: write back the cache lines covering the given range
+ * and wait for the completion.
+ */
+static void
+persist_flush(const void *addr, size_t len)
+{
+	const uint8_t *p = (const void *)((uintptr_t)addr &
+	    ~(uintptr_t)(CACHE_LINE_SIZE - 1));
+	const uint8_t *end = (const uint8_t *)addr + len;
+
+	switch (persist_insn) {
+	case FLUSH_CLWB:
+		flush_clwb(p, end);
+		break;
+	case FLUSH_CLFLUSHOPT:
+		flush_clflushopt(p, end);
+		break;
+	default:
+		flush_clflush(p, end);
+		break;
+	}
+	_mm_sfence();
+}
+#endif
+
+/*
+ * ringbuf_persist_range: make the given range durable using the given mode.
+ *
+ * => Returns 0 on success and -1 on failure (with errno set).
+ */
+int
+ringbuf_persist_range(const void *addr, size_t len, unsigned mode)
+{
+	uintptr_t start;
+
+	switch (mode) {
+	case RINGBUF_PERSIST_FLUSH:
+#ifdef PERSIST_X86
+		persist_flush(addr, len);
+		return 0;
+#else
+		errno = ENOTSUP;
+		return -1;
+#endif
+	case RINGBUF_PERSIST_MSYNC:
+		start = (uintptr_t)addr & ~persist_pagemask;
+		return msync((void *)start, (uintptr_t)addr + len - start,
+		    MS_SYNC);
+	default:
+		break;
+	}
+	errno = EINVAL;
+	return -1;
+}
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _PERSIST_H_
+#define _PERSIST_H_
+
+#include <stddef.h>
+
+__BEGIN_DECLS
+
+int		ringbuf_persist_range(const void *, size_t, unsigned);
+
+__END_DECLS
+
+#endif
@@ -40,7 +40,18 @@
  *
  *	If the producer cannot acquire the requested length due to little
  *	available space at the end of the buffer, then it will wraparound.
- *	WRAP_LOCK_BIT in 'next' offset is used to lock the 'end' offset.
+ *	WRAP_LOCK_BIT in 'next' offset indicates that the 'end' offset is
+ *	being set.
+ *
+ *	The wrap-around is non-blocking: the producer publishes the 'end'
+ *	and the new 'next' values in its worker structure and then sets
+ *	the 'next' word to WRAP_LOCK_BIT with the new counter and its
+ *	worker index.  Any thread observing such value helps to complete
+ *	the wrap-around: it sets the 'end' offset and then the new 'next'
+ *	value, both using CAS, therefore a preempted producer does not
+ *	stall the others.  The 'end' word is tagged with the counter of
+ *	the wrap-around, so that a late helper cannot set it again after
+ *	the consumer has reset it.
  *
  *	There is an ABA problem if one producer stalls while a pair of
  *	producer and consumer would both successfully wrap-around and set
@@ -52,8 +63,36 @@
  *	The same ABA problem could also cause a stale 'ready' offset,
  *	which could be observed by the consumer.  We set WRAP_LOCK_BIT in
  *	the 'seen' value before advancing the 'next' and clear this bit
- *	after the successful advancing; this ensures that only the stable
- *	'ready' is observed by the consumer.
+ *	after the successful advancing.  The consumer does not wait for
+ *	such unstable value: it is either the start of the range being
+ *	acquired or stale (the CAS will fail).  In the former case, the
+ *	value cannot be behind the range already returned to the consumer,
+ *	therefore the consumer caps the 'ready' offset at the greater of
+ *	the two, which is safe in both cases.
+ *
+ * Peek
+ *
+ *	Other threads may look at the ready range without consuming it.
+ *	The consumer updates the 'written' offset (and resets the 'end'
+ *	offset) within a sequence lock: the generation number is odd while
+ *	the update is in progress.  The reader observes the generation,
+ *	computes the ready range the same way as the consumer, copies the
+ *	data and then checks that the generation did not change.  Since
+ *	the producers cannot go beyond the 'written' offset, an unchanged
+ *	generation guarantees that the copied range was not overwritten.
+ *
+ * Durability
+ *
+ *	The ring buffer (both the object and the data space) may reside
+ *	in a file mapping, e.g. on a DAX file system.  The durable produce
+ *	writes back the range before clearing the 'seen' offset, therefore
+ *	the consumer can only see the data which is already durable.  The
+ *	durable release writes back the 'written' offset.  After a crash,
+ *	the other offsets are stale: the recovery resets the workers and
+ *	rebuilds the 'next' and 'end' offsets by scanning the data space
+ *	from the 'written' offset, up to the last valid record.  Since the
+ *	ring buffer does not interpret the data, the validation is done by
+ *	the caller's scan function (see ringbuf_frame_recover()).
  */
 
 #include <stdio.h>
@@ -66,6 +105,7 @@
 #include <errno.h>
 
 #include "ringbuf.h"
+#include "persist.h"
 #include "utils.h"
 
 #define	RBUF_OFF_MASK	(0x00000000ffffffffUL)
@@ -75,11 +115,19 @@
 #define	WRAP_COUNTER	(0x7fffffff00000000UL)
 #define	WRAP_INCR(x)	(((x) + 0x100000000UL) & WRAP_COUNTER)
 
+/* The 'end' word: the wrap-around counter and the offset (if set). */
+#define	END_NONE	RBUF_OFF_MASK
+#define	END_OFF(x)	((x) & RBUF_OFF_MASK)
+
 typedef uint64_t	ringbuf_off_t;
 
 struct ringbuf_worker {
 	volatile ringbuf_off_t	seen_off;
 	int			registered;
+
+	/* The pending wrap-around: the 'end' and the new 'next'. */
+	volatile ringbuf_off_t	wrap_end;
+	volatile ringbuf_off_t	wrap_next;
 };
 
 struct ringbuf {
@@ -89,13 +137,15 @@ struct ringbuf {
 	/*
 	 * The NEXT hand is atomically updated by the producer.
 	 * WRAP_LOCK_BIT is set in case of wrap-around; in such case,
-	 * the producer can update the 'end' offset.
+	 * the 'end' offset is being updated (see wrap_complete()).
 	 */
 	volatile ringbuf_off_t	next;
-	ringbuf_off_t		end;
+	volatile ringbuf_off_t	end;
 
 	/* The following are updated by the consumer. */
 	ringbuf_off_t		written;
+	ringbuf_off_t		ready;	/* end of the range returned */
+	volatile uint64_t	wgen;
 	unsigned		nworkers;
 	ringbuf_worker_t	workers[];
 };
@@ -112,7 +162,7 @@ ringbuf_setup(ringbuf_t *rbuf, unsigned nworkers, size_t length)
 	}
 	memset(rbuf, 0, offsetof(ringbuf_t, workers[nworkers]));
 	rbuf->space = length;
-	rbuf->end = RBUF_OFF_MAX;
+	rbuf->end = END_NONE;
 	rbuf->nworkers = nworkers;
 	return 0;
 }
@@ -151,18 +201,62 @@ ringbuf_unregister(ringbuf_t *rbuf, ringbuf_worker_t *w)
 	(void)rbuf;
 }
 
+/*
+ * wrap_complete: complete the wrap-around indicated by the given 'next'
+ * value (with WRAP_LOCK_BIT set) on behalf of the producer.  Any thread
+ * may call it; only the first one to get to each step has an effect.
+ */
+static void
+wrap_complete(ringbuf_t *rbuf, ringbuf_off_t locked)
+{
+	const ringbuf_off_t tag = locked & WRAP_COUNTER;
+	ringbuf_worker_t *w = &rbuf->workers[locked & RBUF_OFF_MASK];
+	ringbuf_off_t wrap_end, wrap_next, end;
+
+	ASSERT((locked & RBUF_OFF_MASK) < rbuf->nworkers);
+
+	/*
+	 * Get the values published by the producer.  They are valid if
+	 * the 'next' word did not change: the producer cannot start
+	 * another wrap-around until this one is complete.
+	 */
+	wrap_end = atomic_load_explicit(&w->wrap_end, memory_order_relaxed);
+	wrap_next = atomic_load_explicit(&w->wrap_next, memory_order_relaxed);
+	atomic_thread_fence(memory_order_acquire);
+	if (atomic_load_explicit(&rbuf->next, memory_order_relaxed) != locked) {
+		return;
+	}
+
+	/*
+	 * Set the 'end' offset, unless it was already set for this
+	 * wrap-around (or even reset by the consumer).  The CAS fails if
+	 * the word changed since it was observed.
+	 */
+	end = atomic_load_explicit(&rbuf->end, memory_order_relaxed);
+	if ((end & WRAP_COUNTER) != tag) {
+		ASSERT(END_OFF(end) == END_NONE);
+		atomic_compare_exchange_weak(&rbuf->end, &end, tag | wrap_end);
+	}
+
+	/*
+	 * Unlock: the 'end' offset is visible before the new 'next'.
+	 * Note: CAS issues a full memory barrier.
+	 */
+	atomic_compare_exchange_weak(&rbuf->next, &locked, wrap_next);
+}
+
 /*
  * stable_nextoff: capture and return a stable value of the 'next' offset.
+ * If a wrap-around is in progress, then help to complete it.
  */
 static inline ringbuf_off_t
 stable_nextoff(ringbuf_t *rbuf)
 {
-	unsigned count = SPINLOCK_BACKOFF_MIN;
 	ringbuf_off_t next;
 retry:
 	next = atomic_load_explicit(&rbuf->next, memory_order_acquire);
 	if (next & WRAP_LOCK_BIT) {
-		SPINLOCK_BACKOFF(count);
+		wrap_complete(rbuf, next);
 		goto retry;
 	}
 	ASSERT((next & RBUF_OFF_MASK) < rbuf->space);
@@ -170,20 +264,82 @@ retry:
 }
 
 /*
- * stable_seenoff: capture and return a stable value of the 'seen' offset.
+ * end_offset: return the 'end' offset or the end of the buffer, if not set.
  */
 static inline ringbuf_off_t
-stable_seenoff(ringbuf_worker_t *w)
+end_offset(ringbuf_t *rbuf)
 {
-	unsigned count = SPINLOCK_BACKOFF_MIN;
-	ringbuf_off_t seen_off;
-retry:
-	seen_off = atomic_load_explicit(&w->seen_off, memory_order_acquire);
-	if (seen_off & WRAP_LOCK_BIT) {
-		SPINLOCK_BACKOFF(count);
-		goto retry;
+	const ringbuf_off_t end = atomic_load_explicit(&rbuf->end,
+	    memory_order_relaxed);
+	return MIN(rbuf->space, END_OFF(end));
+}
+
+/*
+ * observe_ready: return the smallest 'ready' offset observed by the
+ * producers, which is not behind the given 'written' offset.  The
+ * unstable 'seen' offsets are taken as not behind the 'floor' offset,
+ * which must be valid to return.
+ */
+static ringbuf_off_t
+observe_ready(ringbuf_t *rbuf, ringbuf_off_t written, ringbuf_off_t floor)
+{
+	ringbuf_off_t ready = RBUF_OFF_MAX;
+
+	/*
+	 * At this point, some producer might have already triggered the
+	 * wrap-around and some (or all) seen 'ready' values might be in
+	 * the range between 0 and 'written'.  We have to skip them.
+	 */
+	for (unsigned i = 0; i < rbuf->nworkers; i++) {
+		ringbuf_worker_t *w = &rbuf->workers[i];
+		ringbuf_off_t seen_off;
+
+		/*
+		 * Skip if the worker has not registered.
+		 *
+		 * If the 'seen' value is not stable, then do not wait for
+		 * the producer: the value may be stale (see above).
+		 */
+		if (!atomic_load_explicit(&w->registered, memory_order_relaxed))
+			continue;
+		seen_off = atomic_load_explicit(&w->seen_off,
+		    memory_order_acquire);
+		if (seen_off & WRAP_LOCK_BIT) {
+			seen_off &= ~WRAP_LOCK_BIT;
+			if (seen_off >= written) {
+				seen_off = MAX(seen_off, floor);
+			}
+		}
+
+		/*
+		 * Ignore the offsets after the possible wrap-around.
+		 * We are interested in the smallest seen offset that is
+		 * not behind the 'written' offset.
+		 */
+		if (seen_off >= written) {
+			ready = MIN(seen_off, ready);
+		}
 	}
-	return seen_off;
+	return ready;
+}
+
+/*
+ * written_begin, written_end: enter and exit the sequence lock protecting
+ * the updates of the 'written' and 'end' offsets.  Only the consumer.
+ */
+static inline void
+written_begin(ringbuf_t *rbuf)
+{
+	atomic_store_explicit(&rbuf->wgen, rbuf->wgen + 1,
+	    memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+static inline void
+written_end(ringbuf_t *rbuf)
+{
+	atomic_store_explicit(&rbuf->wgen, rbuf->wgen + 1,
+	    memory_order_release);
 }
 
 /*
@@ -237,21 +393,30 @@ ringbuf_acquire(ringbuf_t *rbuf, ringbuf_worker_t *w, size_t len)
 			/*
 			 * Wrap-around and start from the beginning.
 			 *
-			 * If we would exceed the buffer, then attempt to
-			 * acquire the WRAP_LOCK_BIT and use the space in
-			 * the beginning.  If we used all space exactly to
-			 * the end, then reset to 0.
+			 * If we would exceed the buffer, then publish the
+			 * 'end' offset and the new 'next' value, and attempt
+			 * to set the WRAP_LOCK_BIT with our worker index to
+			 * use the space in the beginning.  If we used all
+			 * space exactly to the end, then reset to 0.
 			 *
 			 * Check the invariant again.
 			 */
-			target = exceed ? (WRAP_LOCK_BIT | len) : 0;
-			if ((target & RBUF_OFF_MASK) >= written) {
+			target = exceed ? len : 0;
+			if (target >= written) {
 				atomic_store_explicit(&w->seen_off,
 				    RBUF_OFF_MAX, memory_order_release);
 				return -1;
 			}
 			/* Increment the wrap-around counter. */
 			target |= WRAP_INCR(seen & WRAP_COUNTER);
+			if (exceed) {
+				atomic_store_explicit(&w->wrap_end, next,
+				    memory_order_relaxed);
+				atomic_store_explicit(&w->wrap_next, target,
+				    memory_order_relaxed);
+				target = WRAP_LOCK_BIT | (target & WRAP_COUNTER) |
+				    (ringbuf_off_t)(w - rbuf->workers);
+			}
 		} else {
 			/* Preserve the wrap-around counter. */
 			target |= seen & WRAP_COUNTER;
@@ -269,22 +434,15 @@ ringbuf_acquire(ringbuf_t *rbuf, ringbuf_worker_t *w, size_t len)
 
 	/*
 	 * If we set the WRAP_LOCK_BIT in the 'next' (because we exceed
-	 * the remaining space and need to wrap-around), then save the
-	 * 'end' offset and release the lock.
+	 * the remaining space and need to wrap-around), then set the
+	 * 'end' offset and release the lock, unless another thread has
+	 * already done it for us.
 	 */
 	if (__predict_false(target & WRAP_LOCK_BIT)) {
 		/* Cannot wrap-around again if consumer did not catch-up. */
 		ASSERT(rbuf->written <= next);
-		ASSERT(rbuf->end == RBUF_OFF_MAX);
-		rbuf->end = next;
-		next = 0;
-
-		/*
-		 * Unlock: ensure the 'end' offset reaches global
-		 * visibility before the lock is released.
-		 */
-		atomic_store_explicit(&rbuf->next,
-		    (target & ~WRAP_LOCK_BIT), memory_order_release);
+		wrap_complete(rbuf, target);
+		return 0;
 	}
 	ASSERT((target & RBUF_OFF_MASK) <= rbuf->space);
 	return (ssize_t)next;
@@ -309,7 +467,7 @@ ringbuf_produce(ringbuf_t *rbuf, ringbuf_worker_t *w)
 size_t
 ringbuf_consume(ringbuf_t *rbuf, size_t *offset)
 {
-	ringbuf_off_t written = rbuf->written, next, ready;
+	ringbuf_off_t written = rbuf->written, nextw, next, ready;
 	size_t towrite;
 retry:
 	/*
@@ -318,52 +476,27 @@ retry:
 	 * and the 'next' offset will be the *preliminary* target buffer
 	 * area to be consumed.
 	 */
-	next = stable_nextoff(rbuf) & RBUF_OFF_MASK;
+	nextw = stable_nextoff(rbuf);
+	next = nextw & RBUF_OFF_MASK;
 	if (written == next) {
 		/* If producers did not advance, then nothing to do. */
 		return 0;
 	}
 
 	/*
-	 * Observe the 'ready' offset of each producer.
-	 *
-	 * At this point, some producer might have already triggered the
-	 * wrap-around and some (or all) seen 'ready' values might be in
-	 * the range between 0 and 'written'.  We have to skip them.
+	 * Observe the 'ready' offset of each producer.  The range
+	 * returned previously is still valid.
 	 */
-	ready = RBUF_OFF_MAX;
-
-	for (unsigned i = 0; i < rbuf->nworkers; i++) {
-		ringbuf_worker_t *w = &rbuf->workers[i];
-		ringbuf_off_t seen_off;
-
-		/*
-		 * Skip if the worker has not registered.
-		 *
-		 * Get a stable 'seen' value.  This is necessary since we
-		 * want to discard the stale 'seen' values.
-		 */
-		if (!atomic_load_explicit(&w->registered, memory_order_relaxed))
-			continue;
-		seen_off = stable_seenoff(w);
-
-		/*
-		 * Ignore the offsets after the possible wrap-around.
-		 * We are interested in the smallest seen offset that is
-		 * not behind the 'written' offset.
-		 */
-		if (seen_off >= written) {
-			ready = MIN(seen_off, ready);
-		}
-		ASSERT(ready >= written);
-	}
+	ASSERT(rbuf->ready >= written);
+	ready = observe_ready(rbuf, written, rbuf->ready);
+	ASSERT(ready >= written);
 
 	/*
 	 * Finally, we need to determine whether wrap-around occurred
 	 * and deduct the safe 'ready' offset.
 	 */
 	if (next < written) {
-		const ringbuf_off_t end = MIN(rbuf->space, rbuf->end);
+		const ringbuf_off_t end = end_offset(rbuf);
 
 		/*
 		 * Wrap-around case.  Check for the cut off first.
@@ -374,19 +507,24 @@ retry:
 		 * done (the observed 'ready' offsets are clear).
 		 */
 		if (ready == RBUF_OFF_MAX && written == end) {
+			written_begin(rbuf);
+
 			/*
-			 * Clear the 'end' offset if was set.
+			 * Clear the 'end' offset, if was set, and tag it
+			 * with the counter of this wrap-around.
 			 */
-			if (rbuf->end != RBUF_OFF_MAX) {
-				rbuf->end = RBUF_OFF_MAX;
-			}
+			atomic_store_explicit(&rbuf->end,
+			    (nextw & WRAP_COUNTER) | END_NONE,
+			    memory_order_relaxed);
 
 			/*
 			 * Wrap-around the consumer and start from zero.
 			 */
 			written = 0;
+			rbuf->ready = 0;
 			atomic_store_explicit(&rbuf->written,
 			    written, memory_order_release);
+			written_end(rbuf);
 			goto retry;
 		}
 
@@ -408,6 +546,7 @@ retry:
 	}
 	towrite = ready - written;
 	*offset = written;
+	rbuf->ready = ready;
 
 	ASSERT(ready >= written);
 	ASSERT(towrite <= rbuf->space);
@@ -423,8 +562,223 @@ ringbuf_release(ringbuf_t *rbuf, size_t nbytes)
 	const size_t nwritten = rbuf->written + nbytes;
 
 	ASSERT(rbuf->written <= rbuf->space);
-	ASSERT(rbuf->written <= rbuf->end);
+	ASSERT(rbuf->written <= END_OFF(rbuf->end));
 	ASSERT(nwritten <= rbuf->space);
 
+	written_begin(rbuf);
 	rbuf->written = (nwritten == rbuf->space) ? 0 : nwritten;
+	written_end(rbuf);
+	if (rbuf->written == 0) {
+		rbuf->ready = 0;
+	}
+}
+
+/*
+ * ringbuf_get_usage: return the number of bytes acquired by the producers
+ * but not yet released by the consumer.  Any thread may call it, but the
+ * value is approximate if there are concurrent updates.
+ */
+size_t
+ringbuf_get_usage(ringbuf_t *rbuf)
+{
+	const ringbuf_off_t written =
+	    atomic_load_explicit(&rbuf->written, memory_order_relaxed);
+	const ringbuf_off_t next = stable_nextoff(rbuf) & RBUF_OFF_MASK;
+	ringbuf_off_t end;
+
+	if (next >= written) {
+		return next - written;
+	}
+	end = end_offset(rbuf);
+	return end > written ? end - written + next : next;
+}
+
+/*
+ * ringbuf_get_space: return the length of the data space.  Note: the
+ * length requested by ringbuf_acquire() must be less than it.
+ */
+size_t
+ringbuf_get_space(ringbuf_t *rbuf)
+{
+	return rbuf->space;
+}
+
+/*
+ * ringbuf_get_frontier: return the position up to which the space has
+ * been acquired by the producers: the wrap-around counter (lap number)
+ * in the upper 32 bits and the offset in the lower 32 bits.  The space
+ * at the given offset of the given lap is overwritten once the frontier
+ * is past it.  Any thread may call it.
+ */
+uint64_t
+ringbuf_get_frontier(ringbuf_t *rbuf)
+{
+	return stable_nextoff(rbuf);
+}
+
+/*
+ * ringbuf_peek: get a contiguous range which is ready to be consumed,
+ * without consuming it.  May be used concurrently with the consumer.
+ *
+ * => Returns the length of the range (zero if there is nothing to read)
+ *    and sets the generation number to pass to ringbuf_peek_validate().
+ * => The data must be copied out before the validation.
+ */
+size_t
+ringbuf_peek(ringbuf_t *rbuf, size_t *offset, uint64_t *gen)
+{
+	ringbuf_off_t written, next, ready;
+
+	*gen = atomic_load_explicit(&rbuf->wgen, memory_order_acquire);
+	if (*gen & 1) {
+		/* The consumer is updating the offsets. */
+		return 0;
+	}
+	written = atomic_load_explicit(&rbuf->written, memory_order_relaxed);
+retry:
+	next = stable_nextoff(rbuf) & RBUF_OFF_MASK;
+	if (written == next) {
+		return 0;
+	}
+	ready = observe_ready(rbuf, written, written);
+
+	/*
+	 * Same as ringbuf_consume(), but the consumer wrap-around is
+	 * only simulated.  The observed values may be inconsistent
+	 * due to the concurrent consumer, in which case the validation
+	 * will fail; just make sure the range does not go out of bounds.
+	 */
+	if (next < written) {
+		const ringbuf_off_t end = end_offset(rbuf);
+
+		if (ready == RBUF_OFF_MAX && written == end) {
+			written = 0;
+			goto retry;
+		}
+		ready = MIN(ready, end);
+	} else {
+		ready = MIN(ready, next);
+	}
+	if (ready < written || ready > rbuf->space) {
+		return 0;
+	}
+	*offset = written;
+	return ready - written;
+}
+
+/*
+ * ringbuf_peek_validate: check whether the data of the range obtained
+ * using ringbuf_peek() could have been released and overwritten.
+ *
+ * => Returns 0 if the copied data is valid and -1 otherwise.
+ */
+int
+ringbuf_peek_validate(ringbuf_t *rbuf, uint64_t gen)
+{
+	atomic_thread_fence(memory_order_acquire);
+	if ((gen & 1) || atomic_load_explicit(&rbuf->wgen,
+	    memory_order_relaxed) != gen) {
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * ringbuf_produce_durable: write back the given range (the acquired
+ * space or its part) using the given persistence mode and then produce.
+ *
+ * => Returns 0 on success and -1 on failure, in which case the range
+ *    is not produced; the caller may retry.
+ */
+int
+ringbuf_produce_durable(ringbuf_t *rbuf, ringbuf_worker_t *w,
+    const void *ptr, size_t len, unsigned mode)
+{
+	if (ringbuf_persist_range(ptr, len, mode) == -1) {
+		return -1;
+	}
+	ringbuf_produce(rbuf, w);
+	return 0;
+}
+
+/*
+ * ringbuf_release_durable: release the consumed range and write back
+ * the 'written' offset.
+ *
+ * => Returns 0 on success and -1 if the write-back failed (the range
+ *    is released regardless, but it may be recovered after a crash).
+ */
+int
+ringbuf_release_durable(ringbuf_t *rbuf, size_t nbytes, unsigned mode)
+{
+	ringbuf_release(rbuf, nbytes);
+	return ringbuf_persist_range(&rbuf->written, sizeof(ringbuf_off_t),
+	    mode);
+}
+
+/*
+ * ringbuf_recover: reset the ring buffer, which survived a crash, and
+ * restore the range to be consumed.  Must be called before any other
+ * operation; the workers must register again.
+ *
+ * => The scan function is called with an offset and the length of the
+ *    space; it must return the length of the valid data at that offset.
+ *    The rest of the space is free, e.g. the function may clear it.
+ * => Returns the number of bytes recovered or -1 with errno set to
+ *    EINVAL if the object is not valid or the scan function returned
+ *    an inconsistent length (the object is not changed in such case).
+ */
+ssize_t
+ringbuf_recover(ringbuf_t *rbuf, ringbuf_scan_t scan, void *arg)
+{
+	const size_t space = rbuf->space;
+	const ringbuf_off_t written = rbuf->written;
+	size_t tail, head = 0;
+	ringbuf_off_t next;
+
+	if (space >= RBUF_OFF_MASK || written >= space) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/*
+	 * Scan from the 'written' offset towards the end.  If there is
+	 * valid data at the beginning, then the producers wrapped around
+	 * and the scan stopped at the 'end' offset.  Note: the producers
+	 * cannot catch up with the consumer, neither go exactly to the
+	 * end of the buffer if the 'written' offset is zero.  The data
+	 * space is not trusted, therefore check the lengths.
+	 */
+	tail = scan(arg, written, space - written);
+	if (tail > space - written || (written == 0 && tail == space)) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (written && (head = scan(arg, 0, written)) >= written) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (unsigned i = 0; i < rbuf->nworkers; i++) {
+		ringbuf_worker_t *w = &rbuf->workers[i];
+
+		w->seen_off = RBUF_OFF_MAX;
+		w->registered = false;
+	}
+	rbuf->wgen += rbuf->wgen & 1;
+	rbuf->ready = written;
+	rbuf->end = (rbuf->next & WRAP_COUNTER) | END_NONE;
+
+	if (head) {
+		if (written + tail < space) {
+			rbuf->end = (rbuf->next & WRAP_COUNTER) |
+			    (written + tail);
+		}
+		next = head;
+	} else {
+		next = (written + tail == space) ? 0 : written + tail;
+	}
+	rbuf->next = (rbuf->next & WRAP_COUNTER) | next;
+	atomic_thread_fence(memory_order_release);
+	return tail + head;
 }
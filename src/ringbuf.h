@@ -13,6 +13,13 @@ __BEGIN_DECLS
 typedef struct ringbuf ringbuf_t;
 typedef struct ringbuf_worker ringbuf_worker_t;
 
+/* Persistence modes. */
+#define	RINGBUF_PERSIST_FLUSH	1	/* cache line write-back (DAX) */
+#define	RINGBUF_PERSIST_MSYNC	2	/* msync(2) of the file mapping */
+
+/* Returns the length of the valid data at the given offset. */
+typedef size_t (*ringbuf_scan_t)(void *, size_t, size_t);
+
 int		ringbuf_setup(ringbuf_t *, unsigned, size_t);
 void		ringbuf_get_sizes(unsigned, size_t *, size_t *);
 
@@ -24,6 +31,17 @@ void		ringbuf_produce(ringbuf_t *, ringbuf_worker_t *);
 size_t		ringbuf_consume(ringbuf_t *, size_t *);
 void		ringbuf_release(ringbuf_t *, size_t);
 
+size_t		ringbuf_get_usage(ringbuf_t *);
+size_t		ringbuf_get_space(ringbuf_t *);
+uint64_t	ringbuf_get_frontier(ringbuf_t *);
+size_t		ringbuf_peek(ringbuf_t *, size_t *, uint64_t *);
+int		ringbuf_peek_validate(ringbuf_t *, uint64_t);
+
+int		ringbuf_produce_durable(ringbuf_t *, ringbuf_worker_t *,
+		    const void *, size_t, unsigned);
+int		ringbuf_release_durable(ringbuf_t *, size_t, unsigned);
+ssize_t		ringbuf_recover(ringbuf_t *, ringbuf_scan_t, void *);
+
 __END_DECLS
 
 #endif
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * FIFO allocator on top of the ring buffer.
+ *
+ * Suitable for the short-lived objects which are freed in (roughly)
+ * the allocation order.  The allocation acquires the space for the
+ * block header and the object and immediately produces it.  The free
+ * operation marks the block as free and then tries to take the consumer
+ * role: the consumer releases the longest prefix of the freed blocks.
+ * An object freed out of order is reclaimed only once all the preceding
+ * blocks are freed.
+ *
+ * Consumer role
+ *
+ *	The ring buffer has a single consumer, therefore the role is taken
+ *	using a try-lock flag; if it is busy, then the current holder will
+ *	take care of the freed block.  To avoid the lost update, where the
+ *	holder has already passed the block being freed, the holder peeks
+ *	at the head block after dropping the flag and retries if the block
+ *	is free.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_arena.h"
+#include "utils.h"
+
+#define	ARENA_ALIGN		16
+
+#define	ARENA_BLK_USED		0
+#define	ARENA_BLK_FREE		1
+
+typedef struct {
+	uint32_t		size;	/* including the header */
+	volatile uint32_t	state;
+	uint64_t		_reserved;
+} arena_blk_t;
+
+#define	ARENA_BLK_SIZE(len)	\
+    roundup2(sizeof(arena_blk_t) + (len), ARENA_ALIGN)
+
+struct ringbuf_arena {
+	volatile unsigned	reclaiming;
+	size_t			space;
+	size_t			rbuf_off;
+	size_t			buf_off;
+};
+
+static inline ringbuf_t *
+arena_rbuf(ringbuf_arena_t *a)
+{
+	return (void *)((uint8_t *)a + a->rbuf_off);
+}
+
+static inline arena_blk_t *
+arena_blk(ringbuf_arena_t *a, size_t off)
+{
+	return (void *)((uint8_t *)a + a->buf_off + off);
+}
+
+static void
+arena_layout(ringbuf_arena_t *a, unsigned nworkers, size_t space)
+{
+	size_t rbuf_size;
+
+	ringbuf_get_sizes(nworkers, &rbuf_size, NULL);
+	a->space = space;
+	a->rbuf_off = roundup2(sizeof(ringbuf_arena_t), CACHE_LINE_SIZE);
+	a->buf_off = roundup2(a->rbuf_off + rbuf_size, CACHE_LINE_SIZE);
+}
+
+/*
+ * ringbuf_arena_get_size: return the size of the arena object for the
+ * given number of workers (allocating threads) and space.
+ */
+size_t
+ringbuf_arena_get_size(unsigned nworkers, size_t space)
+{
+	ringbuf_arena_t a;
+
+	arena_layout(&a, nworkers, space);
+	return a.buf_off + space;
+}
+
+/*
+ * ringbuf_arena_setup: initialise the arena object (of the size given
+ * by ringbuf_arena_get_size).
+ */
+int
+ringbuf_arena_setup(ringbuf_arena_t *a, unsigned nworkers, size_t space)
+{
+	if (space < ARENA_BLK_SIZE(1) || (space % ARENA_ALIGN) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(a, 0, sizeof(ringbuf_arena_t));
+	arena_layout(a, nworkers, space);
+	return ringbuf_setup(arena_rbuf(a), nworkers, space);
+}
+
+/*
+ * ringbuf_arena_register: register the allocating worker.
+ */
+ringbuf_worker_t *
+ringbuf_arena_register(ringbuf_arena_t *a, unsigned i)
+{
+	return ringbuf_register(arena_rbuf(a), i);
+}
+
+/*
+ * ringbuf_arena_alloc: allocate an object of the given length.
+ *
+ * => The object is aligned to 16 bytes.
+ * => Returns NULL if there is not enough space.
+ */
+void *
+ringbuf_arena_alloc(ringbuf_arena_t *a, ringbuf_worker_t *w, size_t len)
+{
+	ringbuf_t *rbuf = arena_rbuf(a);
+	const size_t size = ARENA_BLK_SIZE(len);
+	arena_blk_t *blk;
+	ssize_t off;
+
+	if (size > a->space) {
+		return NULL;
+	}
+	if ((off = ringbuf_acquire(rbuf, w, size)) == -1) {
+		return NULL;
+	}
+	blk = arena_blk(a, off);
+	blk->size = size;
+	blk->state = ARENA_BLK_USED;
+	ringbuf_produce(rbuf, w);
+	return blk + 1;
+}
+
+/*
+ * arena_reclaim: release the prefix of the freed blocks.
+ */
+static void
+arena_reclaim(ringbuf_arena_t *a)
+{
+	ringbuf_t *rbuf = arena_rbuf(a);
+	size_t len, off;
+
+	while ((len = ringbuf_consume(rbuf, &off)) != 0) {
+		size_t pos = 0;
+
+		while (pos < len) {
+			const arena_blk_t *blk = arena_blk(a, off + pos);
+
+			if (atomic_load_explicit(&blk->state,
+			    memory_order_acquire) != ARENA_BLK_FREE) {
+				break;
+			}
+			pos += blk->size;
+		}
+		ASSERT(pos <= len);
+		if (pos == 0) {
+			break;
+		}
+		ringbuf_release(rbuf, pos);
+	}
+}
+
+/*
+ * arena_head_free: check whether the oldest block is free.
+ */
+static bool
+arena_head_free(ringbuf_arena_t *a)
+{
+	ringbuf_t *rbuf = arena_rbuf(a);
+	size_t off;
+	uint64_t gen;
+
+	if (ringbuf_peek(rbuf, &off, &gen) == 0) {
+		return false;
+	}
+	return atomic_load_explicit(&arena_blk(a, off)->state,
+	    memory_order_relaxed) == ARENA_BLK_FREE;
+}
+
+/*
+ * ringbuf_arena_free: free the object.
+ */
+void
+ringbuf_arena_free(ringbuf_arena_t *a, void *ptr)
+{
+	arena_blk_t *blk = (arena_blk_t *)ptr - 1;
+	unsigned unlocked = 0;
+
+	ASSERT((uint8_t *)blk >= (uint8_t *)arena_blk(a, 0));
+	ASSERT((uint8_t *)blk < (uint8_t *)arena_blk(a, a->space));
+	ASSERT(blk->state == ARENA_BLK_USED);
+
+	atomic_store_explicit(&blk->state, ARENA_BLK_FREE,
+	    memory_order_release);
+	do {
+		/*
+		 * Take the consumer role or leave the block to the
+		 * current holder (see the description at the top).
+		 */
+		if (!atomic_compare_exchange_weak(&a->reclaiming,
+		    &unlocked, 1)) {
+			break;
+		}
+		arena_reclaim(a);
+		atomic_store_explicit(&a->reclaiming, 0, memory_order_release);
+		atomic_thread_fence(memory_order_seq_cst);
+	} while (arena_head_free(a));
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_ARENA_H_
+#define _RINGBUF_ARENA_H_
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_arena ringbuf_arena_t;
+
+size_t		ringbuf_arena_get_size(unsigned, size_t);
+int		ringbuf_arena_setup(ringbuf_arena_t *, unsigned, size_t);
+ringbuf_worker_t *ringbuf_arena_register(ringbuf_arena_t *, unsigned);
+
+void *		ringbuf_arena_alloc(ringbuf_arena_t *, ringbuf_worker_t *,
+		    size_t);
+void		ringbuf_arena_free(ringbuf_arena_t *, void *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Request/response channel on top of the ring buffer.
+ *
+ * The clients share a single MPSC request ring, while each client has
+ * a private response slot.  A client can have only one outstanding
+ * request at a time, therefore the correlation ID is just a per-client
+ * sequence number: it is incremented only by the owner of the slot, so
+ * no atomic operations are necessary for the allocation.
+ *
+ * Client
+ *
+ *	Acquires the space in the request ring, writes the request header
+ *	(client number and sequence) and the payload, produces it and then
+ *	waits until the 'done' sequence in its slot matches the request.
+ *
+ * Server
+ *
+ *	Consumes a range of requests, invokes the handler for each of them
+ *	letting it write the response directly into the client slot, then
+ *	publishes the sequence as done and releases the whole range.
+ *
+ * Completion wait
+ *
+ *	The client either busy-polls the 'done' word or, after a short
+ *	spin, sleeps on it using futex(2).  In the latter case, the client
+ *	sets the 'waiting' flag, issues a full memory barrier and re-checks
+ *	the 'done' word; the server stores 'done', issues a full barrier
+ *	and checks the 'waiting' flag.  Either the client observes the new
+ *	value or the server observes the flag and wakes the client up, so
+ *	the system call is avoided on the fast path.
+ *
+ * All the structures are referenced using the offsets, therefore the
+ * channel object can be placed in the shared memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_chan.h"
+#include "utils.h"
+
+/* Number of the back-off rounds before going to sleep. */
+#define	CHAN_SPIN_ROUNDS	16
+
+typedef struct {
+	uint32_t		len;
+	uint32_t		client;
+	uint32_t		seq;
+	uint32_t		_reserved;
+} chan_req_t;
+
+#define	CHAN_REQ_SIZE(len)	\
+    roundup2(sizeof(chan_req_t) + (len), sizeof(uint64_t))
+
+typedef struct {
+	volatile uint32_t	done;
+	volatile uint32_t	waiting;
+	uint32_t		seq;
+	uint32_t		len;
+	uint8_t			data[];
+} chan_slot_t;
+
+struct ringbuf_chan {
+	unsigned		nclients;
+	size_t			reqspace;
+	size_t			respmax;
+	size_t			slot_size;
+
+	/* Offsets of the components, relative to the channel object. */
+	size_t			rbuf_off;
+	size_t			workers_off;
+	size_t			worker_size;
+	size_t			reqbuf_off;
+	size_t			slots_off;
+};
+
+static inline ringbuf_t *
+chan_rbuf(ringbuf_chan_t *ch)
+{
+	return (void *)((uint8_t *)ch + ch->rbuf_off);
+}
+
+static inline uint8_t *
+chan_reqbuf(ringbuf_chan_t *ch)
+{
+	return (uint8_t *)ch + ch->reqbuf_off;
+}
+
+/*
+ * chan_worker: return the worker structure of the client, which was
+ * registered during the setup.  Note: ringbuf_get_sizes() with zero
+ * workers gives the offset of the first worker in the ring object.
+ */
+static inline ringbuf_worker_t *
+chan_worker(ringbuf_chan_t *ch, unsigned client)
+{
+	ASSERT(client < ch->nclients);
+	return (void *)((uint8_t *)ch + ch->workers_off +
+	    (size_t)client * ch->worker_size);
+}
+
+static inline chan_slot_t *
+chan_slot(ringbuf_chan_t *ch, unsigned client)
+{
+	ASSERT(client < ch->nclients);
+	return (void *)((uint8_t *)ch + ch->slots_off +
+	    (size_t)client * ch->slot_size);
+}
+
+static void
+chan_layout(ringbuf_chan_t *ch, unsigned nclients,
+    size_t reqspace, size_t respmax)
+{
+	size_t rbuf_hdr_size, rbuf_size, off;
+
+	ringbuf_get_sizes(0, &rbuf_hdr_size, &ch->worker_size);
+	ringbuf_get_sizes(nclients, &rbuf_size, NULL);
+	ch->nclients = nclients;
+	ch->reqspace = reqspace;
+	ch->respmax = respmax;
+	ch->slot_size = roundup2(sizeof(chan_slot_t) + respmax,
+	    CACHE_LINE_SIZE);
+
+	off = roundup2(sizeof(ringbuf_chan_t), CACHE_LINE_SIZE);
+	ch->rbuf_off = off;
+	ch->workers_off = off + rbuf_hdr_size;
+	off = roundup2(off + rbuf_size, CACHE_LINE_SIZE);
+	ch->slots_off = off;
+	off += (size_t)nclients * ch->slot_size;
+	ch->reqbuf_off = off;
+}
+
+/*
+ * ringbuf_chan_get_size: return the size of the channel object for the
+ * given number of clients, request ring length and maximum response.
+ */
+size_t
+ringbuf_chan_get_size(unsigned nclients, size_t reqspace, size_t respmax)
+{
+	ringbuf_chan_t ch;
+
+	chan_layout(&ch, nclients, reqspace, respmax);
+	return ch.reqbuf_off + reqspace;
+}
+
+/*
+ * ringbuf_chan_setup: initialise the channel object (of the size given
+ * by ringbuf_chan_get_size) and register all clients as the producers.
+ */
+int
+ringbuf_chan_setup(ringbuf_chan_t *ch, unsigned nclients,
+    size_t reqspace, size_t respmax)
+{
+	if (nclients == 0 || reqspace < sizeof(uint64_t) ||
+	    respmax > UINT32_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(ch, 0, ringbuf_chan_get_size(nclients, reqspace, respmax));
+	chan_layout(ch, nclients, reqspace, respmax);
+
+	if (ringbuf_setup(chan_rbuf(ch), nclients, reqspace) == -1) {
+		return -1;
+	}
+	for (unsigned i = 0; i < nclients; i++) {
+		(void)ringbuf_register(chan_rbuf(ch), i);
+	}
+	return 0;
+}
+
+/*
+ * chan_wait: wait until the slot completes the given sequence.
+ */
+static void
+chan_wait(chan_slot_t *slot, uint32_t seq, unsigned flags)
+{
+	unsigned count = SPINLOCK_BACKOFF_MIN, rounds = 0;
+	uint32_t done;
+
+	while ((done = atomic_load_explicit(&slot->done,
+	    memory_order_acquire)) != seq) {
+		if ((flags & RINGBUF_CHAN_SLEEP) == 0 ||
+		    rounds++ < CHAN_SPIN_ROUNDS) {
+			SPINLOCK_BACKOFF(count);
+			continue;
+		}
+
+		/*
+		 * Announce that we are going to sleep and re-check.
+		 * Note: futex_wait() will not sleep if 'done' changed.
+		 */
+		atomic_store_explicit(&slot->waiting, 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+		if (atomic_load_explicit(&slot->done,
+		    memory_order_relaxed) == done) {
+			futex_wait(&slot->done, done);
+		}
+		atomic_store_explicit(&slot->waiting, 0, memory_order_relaxed);
+	}
+}
+
+/*
+ * chan_complete: publish the response for the given sequence and wake
+ * up the client, if it is sleeping.
+ */
+static void
+chan_complete(chan_slot_t *slot, uint32_t seq)
+{
+	atomic_store_explicit(&slot->done, seq, memory_order_release);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&slot->waiting, memory_order_relaxed)) {
+		futex_wake(&slot->done, 1);
+	}
+}
+
+/*
+ * ringbuf_chan_call: send the request and wait for the response.
+ *
+ * => The response is copied into the 'resp' buffer, truncated to
+ *    'resplen' bytes.  Returns the full length of the response.
+ * => On failure, returns -1 and sets errno to EAGAIN if the request
+ *    ring is full or EINVAL if the request can never fit it.
+ */
+ssize_t
+ringbuf_chan_call(ringbuf_chan_t *ch, unsigned client,
+    const void *req, size_t reqlen, void *resp, size_t resplen,
+    unsigned flags)
+{
+	ringbuf_t *rbuf = chan_rbuf(ch);
+	ringbuf_worker_t *w = chan_worker(ch, client);
+	chan_slot_t *slot = chan_slot(ch, client);
+	chan_req_t *hdr;
+	ssize_t off;
+	uint32_t seq;
+
+	/* Note: the acquired length must be less than the ring space. */
+	if (reqlen > UINT32_MAX || CHAN_REQ_SIZE(reqlen) >= ch->reqspace) {
+		errno = EINVAL;
+		return -1;
+	}
+	off = ringbuf_acquire(rbuf, w, CHAN_REQ_SIZE(reqlen));
+	if (off == -1) {
+		errno = EAGAIN;
+		return -1;
+	}
+	seq = ++slot->seq;
+
+	hdr = (void *)&chan_reqbuf(ch)[off];
+	hdr->len = reqlen;
+	hdr->client = client;
+	hdr->seq = seq;
+	if (reqlen) {
+		memcpy(hdr + 1, req, reqlen);
+	}
+	ringbuf_produce(rbuf, w);
+
+	chan_wait(slot, seq, flags);
+	if (resplen) {
+		memcpy(resp, slot->data, MIN(resplen, slot->len));
+	}
+	return slot->len;
+}
+
+/*
+ * ringbuf_chan_serve: process a batch of the pending requests.
+ *
+ * => Returns the number of requests served (zero if none were pending).
+ */
+unsigned
+ringbuf_chan_serve(ringbuf_chan_t *ch, ringbuf_chan_handler_t handler,
+    void *arg)
+{
+	ringbuf_t *rbuf = chan_rbuf(ch);
+	const uint8_t *reqbuf = chan_reqbuf(ch);
+	size_t len, off, pos = 0;
+	unsigned n = 0;
+
+	if ((len = ringbuf_consume(rbuf, &off)) == 0) {
+		return 0;
+	}
+	while (pos < len) {
+		const chan_req_t *hdr = (const void *)&reqbuf[off + pos];
+		chan_slot_t *slot = chan_slot(ch, hdr->client);
+		size_t rlen;
+
+		rlen = handler(arg, hdr + 1, hdr->len, slot->data, ch->respmax);
+		ASSERT(rlen <= ch->respmax);
+		slot->len = rlen;
+		chan_complete(slot, hdr->seq);
+
+		pos += CHAN_REQ_SIZE(hdr->len);
+		n++;
+	}
+	ASSERT(pos == len);
+	ringbuf_release(rbuf, len);
+	return n;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_CHAN_H_
+#define _RINGBUF_CHAN_H_
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_chan ringbuf_chan_t;
+
+/*
+ * Request handler: process the request and write the response into the
+ * given buffer (at most 'respmax' bytes).  Returns the response length.
+ */
+typedef size_t (*ringbuf_chan_handler_t)(void *, const void *, size_t,
+    void *, size_t);
+
+/* Wait for the response by busy-polling or sleeping on futex. */
+#define	RINGBUF_CHAN_SPIN	0x00
+#define	RINGBUF_CHAN_SLEEP	0x01
+
+size_t		ringbuf_chan_get_size(unsigned, size_t, size_t);
+int		ringbuf_chan_setup(ringbuf_chan_t *, unsigned, size_t, size_t);
+
+ssize_t		ringbuf_chan_call(ringbuf_chan_t *, unsigned,
+		    const void *, size_t, void *, size_t, unsigned);
+unsigned	ringbuf_chan_serve(ringbuf_chan_t *,
+		    ringbuf_chan_handler_t, void *);
+
+__END_DECLS
+
+#endif
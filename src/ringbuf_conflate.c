@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Conflation: last value per key.
+ *
+ * The keyed records are tracked in a small shared table, indexed by the
+ * hash of the key.  A slot has a state word, containing the offset of
+ * the pending (produced, but not yet claimed by the consumer) record,
+ * and the key of that record.  The state word doubles as a lock, which
+ * is held only while the slot is updated.
+ *
+ * - When publishing a key which has a pending record of the same length,
+ *   the producer updates the payload in place; the ring space is not
+ *   used.  Otherwise, it appends a new record and points the slot to
+ *   it, thus superseding the previous record of the key, if any.
+ *
+ * - The consumer iterator claims the record by clearing the slot, if it
+ *   still points to the record; from this point, the record is not
+ *   updated anymore.  The record is superseded if the slot points to a
+ *   newer record of the same key, in which case it is dropped.
+ *
+ * The keys colliding in a slot displace each other: the displaced record
+ * is not superseded and is delivered, i.e. the conflation is best-effort,
+ * but at most one record per key is pending in each slot.  Note: the
+ * consumer does not wait for the slot lock, which is held for the
+ * duration of a copy or an acquire; if the slot is locked, the record
+ * is left to be claimed in the next pass.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_conflate.h"
+#include "utils.h"
+
+#define	CONF_LOCKED	(0x8000000000000000UL)
+#define	CONF_PENDING	(0x4000000000000000UL)
+#define	CONF_OFF(st)	((size_t)((st) & 0xffffffffUL))
+
+struct conflate_slot {
+	volatile uint64_t	state;
+	volatile uint64_t	key;
+};
+
+struct ringbuf_conflate {
+	unsigned		mask;
+	struct conflate_slot	slot[];
+};
+
+/*
+ * ringbuf_conflate_get_size: return the size of the conflation table.
+ */
+size_t
+ringbuf_conflate_get_size(unsigned nslots)
+{
+	return offsetof(ringbuf_conflate_t, slot[nslots]);
+}
+
+/*
+ * ringbuf_conflate_setup: initialise the table of the given number of
+ * slots, which must be a power of two.
+ */
+int
+ringbuf_conflate_setup(ringbuf_conflate_t *c, unsigned nslots)
+{
+	if (nslots == 0 || (nslots & (nslots - 1)) != 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(c, 0, ringbuf_conflate_get_size(nslots));
+	c->mask = nslots - 1;
+	return 0;
+}
+
+static inline struct conflate_slot *
+conflate_slot(ringbuf_conflate_t *c, uint64_t key)
+{
+	/* Fibonacci hashing. */
+	const uint64_t h = key * 0x9e3779b97f4a7c15UL;
+	return &c->slot[(h >> 32) & c->mask];
+}
+
+/*
+ * conflate_lock: lock the slot and return its state.
+ */
+static uint64_t
+conflate_lock(struct conflate_slot *s)
+{
+	unsigned count = SPINLOCK_BACKOFF_MIN;
+	uint64_t st;
+
+	for (;;) {
+		st = atomic_load_explicit(&s->state, memory_order_relaxed);
+		if ((st & CONF_LOCKED) == 0 && atomic_compare_exchange_weak(
+		    &s->state, &st, st | CONF_LOCKED)) {
+			return st;
+		}
+		SPINLOCK_BACKOFF(count);
+	}
+}
+
+/*
+ * ringbuf_conflate_publish: publish the value of the key, either by
+ * updating its pending record in place or by producing a new record.
+ *
+ * => The 'buf' is the ring buffer data space.
+ * => Returns 1 if the pending record was updated, 0 if a new record was
+ *    produced and -1 if there is no space in the ring (errno is set to
+ *    ENOBUFS).
+ */
+int
+ringbuf_conflate_publish(ringbuf_conflate_t *c, ringbuf_t *rbuf,
+    ringbuf_worker_t *w, void *buf, uint64_t key, const void *data,
+    size_t len)
+{
+	const ringbuf_frame_opts_t opts = { .keyed = true, .key = key };
+	struct conflate_slot *s = conflate_slot(c, key);
+	ringbuf_frame_t *f;
+	uint64_t st;
+
+	st = conflate_lock(s);
+	if ((st & CONF_PENDING) != 0 && s->key == key) {
+		f = (void *)((uint8_t *)buf + CONF_OFF(st));
+		if (f->len == len) {
+			memcpy(ringbuf_frame_data(f), data, len);
+			atomic_store_explicit(&s->state, st,
+			    memory_order_release);
+			return 1;
+		}
+	}
+	if ((f = ringbuf_frame_acquire(rbuf, w, buf, len, &opts)) == NULL) {
+		atomic_store_explicit(&s->state, st, memory_order_release);
+		errno = ENOBUFS;
+		return -1;
+	}
+	memcpy(ringbuf_frame_data(f), data, len);
+
+	/*
+	 * Point the slot to the new record and then produce it; it may
+	 * be updated by other producers even before it is produced.
+	 */
+	s->key = key;
+	atomic_store_explicit(&s->state, CONF_PENDING |
+	    (uint64_t)((uint8_t *)f - (uint8_t *)buf), memory_order_release);
+	ringbuf_frame_produce(rbuf, w, f);
+	return 0;
+}
+
+/*
+ * ringbuf_conflate_claim: claim the record of the key at the given offset
+ * of the data space.  Only the consumer.
+ *
+ * => Returns 1 if the record is the latest value of the key, 0 if it was
+ *    superseded by a newer record, or -1 with errno set to EAGAIN if the
+ *    slot is locked by a producer (the record must be claimed again).
+ */
+int
+ringbuf_conflate_claim(ringbuf_conflate_t *c, uint64_t key, size_t off)
+{
+	struct conflate_slot *s = conflate_slot(c, key);
+	const uint64_t pending = CONF_PENDING | off;
+	uint64_t st, skey;
+again:
+	st = atomic_load_explicit(&s->state, memory_order_acquire);
+	if (__predict_false(st & CONF_LOCKED)) {
+		errno = EAGAIN;
+		return -1;
+	}
+	if (st == pending) {
+		/* Clear the slot: the record is not updated anymore. */
+		if (!atomic_compare_exchange_weak(&s->state, &st, 0)) {
+			goto again;
+		}
+		return 1;
+	}
+
+	/*
+	 * The slot points to another record (or none): if it is of the
+	 * same key, then it is newer.  Validate the key against the state.
+	 */
+	skey = s->key;
+	atomic_thread_fence(memory_order_acquire);
+	if (atomic_load_explicit(&s->state, memory_order_relaxed) != st) {
+		goto again;
+	}
+	return (st & CONF_PENDING) == 0 || skey != key;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_CONFLATE_H_
+#define _RINGBUF_CONFLATE_H_
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+size_t		ringbuf_conflate_get_size(unsigned);
+int		ringbuf_conflate_setup(ringbuf_conflate_t *, unsigned);
+
+int		ringbuf_conflate_publish(ringbuf_conflate_t *, ringbuf_t *,
+		    ringbuf_worker_t *, void *, uint64_t, const void *, size_t);
+int		ringbuf_conflate_claim(ringbuf_conflate_t *, uint64_t, size_t);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Ring-backed task executor.
+ *
+ * Each worker thread owns a ring, where the submitters are the producers.
+ * A task is a closure: a function pointer with up to RINGBUF_EXEC_MAXARG
+ * bytes of the captured state.  The submitter acquires the space in the
+ * ring of a worker, writes the closure inline and produces it; the worker
+ * consumes the range and runs the closures in place, i.e. there is no
+ * allocation or copy per task other than the write into the ring.  The
+ * range is released once all of its closures have run.  Note: the state
+ * is passed aligned to 8 bytes only (not to max_align_t), which saves
+ * the ring space; a state needing more must be copied out by the task.
+ *
+ * - The submitters pick the workers in a round-robin manner, skipping
+ *   the rings which are full.  A batch of tasks is written using a single
+ *   acquire and produce, and results in a single wake-up.
+ *
+ * - An idle worker spins for a few rounds and then blocks on its futex
+ *   word.  The submitter wakes it up only if it announced the sleep; the
+ *   announcement and the check of the ring are ordered by a full barrier
+ *   on both sides, so a wake-up cannot be lost.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_exec.h"
+#include "utils.h"
+
+/* Number of the idle rounds before going to sleep. */
+#define	EXEC_SPIN_ROUNDS	64
+
+/*
+ * The closure in the ring: the header followed by the captured state.
+ */
+struct exec_task {
+	ringbuf_task_fn_t	fn;
+	uint32_t		len;
+	uint32_t		_reserved;
+};
+
+#define	TASK_SIZE(len)	roundup2(sizeof(struct exec_task) + (len), 8)
+
+struct exec_worker {
+	ringbuf_t *		rbuf;
+	uint8_t *		buf;
+	volatile uint32_t	seq;
+	volatile uint32_t	sleeping;
+	uint8_t			_pad[CACHE_LINE_SIZE - sizeof(ringbuf_t *) -
+				    sizeof(uint8_t *) - 2 * sizeof(uint32_t)];
+};
+
+struct exec_submitter {
+	unsigned		next;	/* round-robin cursor */
+	uint8_t			_pad[CACHE_LINE_SIZE - sizeof(unsigned)];
+};
+
+struct ringbuf_exec {
+	unsigned		nworkers;
+	unsigned		nsubmitters;
+	size_t			size;
+	volatile bool		stop;
+	ringbuf_worker_t **	handles; /* [submitter][worker] */
+	struct exec_submitter *	submitters;
+	struct exec_worker	worker[];
+};
+
+/*
+ * ringbuf_exec_create: construct the executor with the given number of
+ * workers and submitters, each worker having a ring of the given size.
+ */
+ringbuf_exec_t *
+ringbuf_exec_create(unsigned nworkers, unsigned nsubmitters, size_t size)
+{
+	ringbuf_exec_t *e;
+	size_t objsize;
+
+	if (nworkers == 0 || nsubmitters == 0) {
+		return NULL;
+	}
+	e = calloc(1, offsetof(ringbuf_exec_t, worker[nworkers]));
+	if (e == NULL) {
+		return NULL;
+	}
+	e->nworkers = nworkers;
+	e->nsubmitters = nsubmitters;
+	e->size = size;
+
+	e->handles = calloc(nworkers * nsubmitters, sizeof(ringbuf_worker_t *));
+	e->submitters = calloc(nsubmitters, sizeof(struct exec_submitter));
+	if (e->handles == NULL || e->submitters == NULL) {
+		goto err;
+	}
+	ringbuf_get_sizes(nsubmitters, &objsize, NULL);
+	for (unsigned i = 0; i < nworkers; i++) {
+		struct exec_worker *wk = &e->worker[i];
+
+		wk->rbuf = malloc(objsize);
+		wk->buf = malloc(size);
+		if (wk->rbuf == NULL || wk->buf == NULL ||
+		    ringbuf_setup(wk->rbuf, nsubmitters, size) == -1) {
+			goto err;
+		}
+		for (unsigned j = 0; j < nsubmitters; j++) {
+			e->handles[j * nworkers + i] =
+			    ringbuf_register(wk->rbuf, j);
+		}
+	}
+	return e;
+err:
+	ringbuf_exec_destroy(e);
+	return NULL;
+}
+
+void
+ringbuf_exec_destroy(ringbuf_exec_t *e)
+{
+	for (unsigned i = 0; i < e->nworkers; i++) {
+		free(e->worker[i].rbuf);
+		free(e->worker[i].buf);
+	}
+	free(e->submitters);
+	free(e->handles);
+	free(e);
+}
+
+/*
+ * exec_notify: wake up the worker, if it is sleeping.
+ */
+static void
+exec_notify(struct exec_worker *wk)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&wk->sleeping, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&wk->seq, 1, memory_order_relaxed);
+		futex_wake(&wk->seq, 1);
+	}
+}
+
+/*
+ * ringbuf_exec_submit_batch: submit the tasks to a worker, all in a
+ * single range.  Only the given submitter (the thread with that index).
+ *
+ * => Returns 0 on success and -1 on failure, setting errno to EAGAIN if
+ *    all rings are full or EINVAL if the state of a task is longer than
+ *    RINGBUF_EXEC_MAXARG or the batch can never fit a ring.
+ */
+int
+ringbuf_exec_submit_batch(ringbuf_exec_t *e, unsigned sub,
+    const ringbuf_task_t *tasks, unsigned n)
+{
+	struct exec_submitter *s = &e->submitters[sub];
+	size_t total = 0;
+
+	ASSERT(sub < e->nsubmitters);
+
+	for (unsigned i = 0; i < n; i++) {
+		if (__predict_false(tasks[i].len > RINGBUF_EXEC_MAXARG)) {
+			errno = EINVAL;
+			return -1;
+		}
+		total += TASK_SIZE(tasks[i].len);
+	}
+
+	/* Note: the acquire of the whole ring space never succeeds. */
+	if (total == 0 || total >= e->size) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (unsigned k = 0; k < e->nworkers; k++) {
+		const unsigned i = (s->next + k) % e->nworkers;
+		struct exec_worker *wk = &e->worker[i];
+		ringbuf_worker_t *w = e->handles[sub * e->nworkers + i];
+		uint8_t *p;
+		ssize_t off;
+
+		if ((off = ringbuf_acquire(wk->rbuf, w, total)) == -1) {
+			continue;
+		}
+		p = &wk->buf[off];
+		for (unsigned j = 0; j < n; j++) {
+			struct exec_task *t = (void *)p;
+
+			t->fn = tasks[j].fn;
+			t->len = tasks[j].len;
+			memcpy(t + 1, tasks[j].arg, tasks[j].len);
+			p += TASK_SIZE(tasks[j].len);
+		}
+		ringbuf_produce(wk->rbuf, w);
+		s->next = i + 1;
+		exec_notify(wk);
+		return 0;
+	}
+	errno = EAGAIN;
+	return -1;
+}
+
+/*
+ * ringbuf_exec_submit: submit the task, copying 'len' bytes of the state
+ * at 'arg' into the ring.  See ringbuf_exec_submit_batch().
+ */
+int
+ringbuf_exec_submit(ringbuf_exec_t *e, unsigned sub, ringbuf_task_fn_t fn,
+    const void *arg, size_t len)
+{
+	const ringbuf_task_t task = { .fn = fn, .arg = arg, .len = len };
+	return ringbuf_exec_submit_batch(e, sub, &task, 1);
+}
+
+/*
+ * ringbuf_exec_run: run the tasks ready in the ring of the given worker.
+ * Only the worker.
+ *
+ * => Returns the number of tasks run.
+ */
+unsigned
+ringbuf_exec_run(ringbuf_exec_t *e, unsigned i)
+{
+	struct exec_worker *wk = &e->worker[i];
+	size_t off, len, pos = 0;
+	unsigned n = 0;
+
+	ASSERT(i < e->nworkers);
+
+	if ((len = ringbuf_consume(wk->rbuf, &off)) == 0) {
+		return 0;
+	}
+	while (pos < len) {
+		struct exec_task *t = (void *)&wk->buf[off + pos];
+
+		t->fn(t + 1);
+		pos += TASK_SIZE(t->len);
+		n++;
+	}
+	ASSERT(pos == len);
+	ringbuf_release(wk->rbuf, len);
+	return n;
+}
+
+static void
+exec_sleep(ringbuf_exec_t *e, struct exec_worker *wk)
+{
+	const uint32_t seq = atomic_load_explicit(&wk->seq,
+	    memory_order_relaxed);
+	size_t off;
+
+	atomic_store_explicit(&wk->sleeping, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (!e->stop && ringbuf_consume(wk->rbuf, &off) == 0) {
+		futex_wait(&wk->seq, seq);
+	}
+	atomic_store_explicit(&wk->sleeping, 0, memory_order_relaxed);
+}
+
+/*
+ * ringbuf_exec_worker: the loop of the given worker: run the tasks and
+ * block when idle.  Returns once the executor is stopped and the ring
+ * is drained.
+ */
+void
+ringbuf_exec_worker(ringbuf_exec_t *e, unsigned i)
+{
+	struct exec_worker *wk = &e->worker[i];
+	unsigned idle = 0, count = SPINLOCK_BACKOFF_MIN;
+
+	ASSERT(i < e->nworkers);
+
+	for (;;) {
+		const bool stop = atomic_load_explicit(&e->stop,
+		    memory_order_acquire);
+
+		if (ringbuf_exec_run(e, i)) {
+			idle = 0;
+			count = SPINLOCK_BACKOFF_MIN;
+			continue;
+		}
+		if (stop) {
+			break;
+		}
+		if (++idle < EXEC_SPIN_ROUNDS) {
+			SPINLOCK_BACKOFF(count);
+			continue;
+		}
+		exec_sleep(e, wk);
+		idle = 0;
+	}
+}
+
+/*
+ * ringbuf_exec_stop: stop the workers, once they run the remaining tasks.
+ * The submitters must have finished.
+ */
+void
+ringbuf_exec_stop(ringbuf_exec_t *e)
+{
+	atomic_store_explicit(&e->stop, true, memory_order_release);
+	atomic_thread_fence(memory_order_seq_cst);
+	for (unsigned i = 0; i < e->nworkers; i++) {
+		struct exec_worker *wk = &e->worker[i];
+
+		atomic_fetch_add_explicit(&wk->seq, 1, memory_order_relaxed);
+		futex_wake(&wk->seq, 1);
+	}
+}
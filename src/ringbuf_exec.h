@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_EXEC_H_
+#define _RINGBUF_EXEC_H_
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_exec ringbuf_exec_t;
+
+/*
+ * The task: the function and its captured state, which is copied into
+ * the ring and passed to the function in place.
+ */
+typedef void (*ringbuf_task_fn_t)(void *);
+
+typedef struct {
+	ringbuf_task_fn_t	fn;
+	const void *		arg;
+	size_t			len;
+} ringbuf_task_t;
+
+/* Maximum length of the captured state (passed aligned to 8 bytes). */
+#define	RINGBUF_EXEC_MAXARG	112
+
+ringbuf_exec_t *ringbuf_exec_create(unsigned, unsigned, size_t);
+void		ringbuf_exec_destroy(ringbuf_exec_t *);
+
+int		ringbuf_exec_submit(ringbuf_exec_t *, unsigned,
+		    ringbuf_task_fn_t, const void *, size_t);
+int		ringbuf_exec_submit_batch(ringbuf_exec_t *, unsigned,
+		    const ringbuf_task_t *, unsigned);
+
+unsigned	ringbuf_exec_run(ringbuf_exec_t *, unsigned);
+void		ringbuf_exec_worker(ringbuf_exec_t *, unsigned);
+void		ringbuf_exec_stop(ringbuf_exec_t *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,1006 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Framed records on top of the ring buffer.
+ *
+ * Each produced range is a record with a small header, which carries
+ * the payload length, flags and the optional 64-bit fields indicated
+ * by the flags.  The consumer walks the consumed range record by record
+ * using an iterator.
+ *
+ * Deadlines
+ *
+ *	A record may carry a deadline (in the caller's time units, e.g.
+ *	the monotonic clock in nanoseconds).  The consumer passes the
+ *	current time when obtaining a range; the records which reached
+ *	their deadline are skipped by inspecting only the header, i.e.
+ *	the payload is never touched.  The expired records at the front
+ *	of the range are released immediately, in bulk, so that a lagging
+ *	consumer catches up by dropping the stale work.
+ *
+ * Fragmentation
+ *
+ *	A message larger than the ring buffer can be streamed as a sequence
+ *	of chunk records, marked with the FIRST and LAST flags and tagged
+ *	with the source ID.  The producer writes as many chunks as there
+ *	is space and resumes once the consumer releases more.  Since the
+ *	chunks of different producers interleave, the consumer reassembles
+ *	the messages per source; alternatively, it can process the chunks
+ *	directly while iterating the records.
+ *
+ * Out-of-line payloads
+ *
+ *	The payloads above a threshold can be stored in the blocks of a
+ *	companion pool, while the ring carries only the header and the
+ *	block index (i.e. 16 bytes).  The consumer gets the block in place
+ *	and releasing the record returns the block to the pool.
+ *
+ * Timestamps
+ *
+ *	A record may carry a timestamp, which is used to merge the records
+ *	of multiple ring buffers in the time order (see ringbuf_merge.c).
+ *
+ * Integrity
+ *
+ *	A record may be protected by CRC32C, e.g. to detect the corruption
+ *	by a faulty producer in the shared memory.  The checksum covers the
+ *	header, the other optional fields and the inline payload; it is
+ *	computed when the record is produced and verified when iterating.
+ *	The records failing the check are dropped.  Note: the out-of-line
+ *	payload is not covered, only its block index.
+ *
+ * Durability
+ *
+ *	If the ring buffer resides in a persistent file mapping, then the
+ *	CRC-protected records may be produced durably: the record is
+ *	written back before it is produced (see ringbuf.c).  The consumer
+ *	iterator in the persistence mode invalidates the headers of the
+ *	released records and writes them back before the 'written' offset,
+ *	so that the stale records are not mistaken for the new ones.  The
+ *	recovery walks the records from the 'written' offset and stops at
+ *	the first one which fails the check, i.e. was not (completely)
+ *	written back; the records after it are not recovered, as they were
+ *	not visible to the consumer either.  The free space is cleared.
+ *	Note: a new record may end in the middle of a stale one, in which
+ *	case the CRC check rejects the remainder (barring a collision).
+ *
+ * Transactions
+ *
+ *	A record may carry a transaction ID, in which case it becomes
+ *	visible only once the transaction is committed, atomically with
+ *	the records in the other rings (see ringbuf_txn.c).  The iterator
+ *	stops at the record of an open transaction.
+ *
+ * Conflation
+ *
+ *	A record may carry a key, in which case a newer value of the same
+ *	key may replace it while it is pending (see ringbuf_conflate.c).
+ *	The iterator claims the latest record of the key before returning
+ *	it and drops the superseded ones.  It stops at the record whose
+ *	slot is being updated by a producer, as for an open transaction.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_frame.h"
+#include "ringbuf_txn.h"
+#include "ringbuf_conflate.h"
+#include "crc32c.h"
+#include "persist.h"
+#include "utils.h"
+
+#define	FRAME_SIZE(hlen, len)	roundup2((hlen) + (len), RINGBUF_FRAME_ALIGN)
+
+static inline size_t
+frame_size(const ringbuf_frame_t *f)
+{
+	const size_t len = (f->flags & RINGBUF_FRAME_BLOB) ? 0 : f->len;
+	return FRAME_SIZE(ringbuf_frame_hdrlen(f), len);
+}
+
+static inline uint64_t *
+frame_field(ringbuf_frame_t *f, unsigned flag)
+{
+	const unsigned idx = __builtin_popcount(f->flags &
+	    RINGBUF_FRAME_OPTMASK & (flag - 1));
+	return (uint64_t *)(void *)(f + 1) + idx;
+}
+
+static inline bool
+frame_expired(const ringbuf_frame_t *f, uint64_t now)
+{
+	return now && (f->flags & RINGBUF_FRAME_DEADLINE) != 0 &&
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_DEADLINE) <= now;
+}
+
+/*
+ * frame_crc: compute the CRC32C of the record, skipping the CRC field.
+ */
+static uint32_t
+frame_crc(const ringbuf_frame_t *f)
+{
+	const uint8_t *p = (const void *)f;
+	const uint8_t *field = (const void *)ringbuf_frame_field(f,
+	    RINGBUF_FRAME_CRC);
+	const size_t len = (f->flags & RINGBUF_FRAME_BLOB) ? 0 : f->len;
+	const uint8_t *end = p + ringbuf_frame_hdrlen(f) + len;
+	uint32_t crc;
+
+	crc = ringbuf_crc32c(0, p, field - p);
+	return ringbuf_crc32c(crc, field + sizeof(uint64_t),
+	    end - field - sizeof(uint64_t));
+}
+
+/*
+ * frame_corrupt: check the record against the remaining space of the
+ * range and, if the record is protected, verify the checksum.
+ */
+static inline bool
+frame_corrupt(const ringbuf_frame_t *f, size_t avail)
+{
+	if ((f->flags & RINGBUF_FRAME_CRC) == 0) {
+		return false;
+	}
+	return frame_size(f) > avail ||
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_CRC) != frame_crc(f);
+}
+
+static inline ringbuf_frame_t *
+frame_at(const ringbuf_frame_iter_t *it, size_t pos)
+{
+	return (void *)&it->buf[it->off + pos];
+}
+
+/*
+ * frame_txn: return the state of the transaction of the record; the
+ * records outside transactions are treated as committed.
+ */
+static inline unsigned
+frame_txn(const ringbuf_frame_iter_t *it, const ringbuf_frame_t *f)
+{
+	if ((f->flags & RINGBUF_FRAME_TXN) == 0 || it->txn == NULL) {
+		return RINGBUF_TXN_COMMITTED;
+	}
+	return ringbuf_txn_state(it->txn,
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_TXN));
+}
+
+/*
+ * frame_txn_done: indicate that the consumer released the record.
+ */
+static inline void
+frame_txn_done(const ringbuf_frame_iter_t *it, const ringbuf_frame_t *f)
+{
+	if ((f->flags & RINGBUF_FRAME_TXN) != 0 && it->txn != NULL) {
+		ringbuf_txn_done(it->txn,
+		    *ringbuf_frame_field(f, RINGBUF_FRAME_TXN));
+	}
+}
+
+/*
+ * frame_claim: claim the record for the consumer.  Returns 1 if claimed,
+ * 0 if the record was superseded by a newer value of its key, or -1 if
+ * its slot is locked, in which case the iteration stops at the record.
+ */
+static inline int
+frame_claim(ringbuf_frame_iter_t *it, const ringbuf_frame_t *f, size_t pos)
+{
+	if ((f->flags & RINGBUF_FRAME_KEY) == 0 || it->conflate == NULL) {
+		return 1;
+	}
+	return ringbuf_conflate_claim(it->conflate,
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_KEY), it->off + pos);
+}
+
+struct ringbuf_reasm {
+	unsigned		nsrc;
+	struct reasm_src {
+		uint8_t *	buf;
+		size_t		len;
+		size_t		cap;
+		bool		active;
+	} src[];
+};
+
+static unsigned
+frame_flags(const ringbuf_frame_opts_t *opts, size_t len)
+{
+	unsigned flags = 0;
+
+	if (opts && opts->deadline) {
+		flags |= RINGBUF_FRAME_DEADLINE;
+	}
+	if (opts && opts->pool && opts->indirect && len >= opts->indirect) {
+		flags |= RINGBUF_FRAME_BLOB;
+	}
+	if (opts && opts->tstamp) {
+		flags |= RINGBUF_FRAME_TSTAMP;
+	}
+	if (opts && opts->crc) {
+		flags |= RINGBUF_FRAME_CRC;
+	}
+	if (opts && opts->txn) {
+		flags |= RINGBUF_FRAME_TXN;
+	}
+	if (opts && opts->keyed) {
+		flags |= RINGBUF_FRAME_KEY;
+	}
+	return flags;
+}
+
+/*
+ * frame_put: drop the references of the records in the given part of
+ * the consumed range: return their out-of-line payload blocks to the pool
+ * and indicate that their transactions were passed.
+ *
+ * => The records are walked as in frame_skip(): a record with a bogus
+ *    length ends the range.  The block of a corrupt record cannot be
+ *    trusted, therefore it is not returned; its transaction is passed,
+ *    if the ID is still of the transaction (see ringbuf_txn_done()).
+ * => Each record is put once, when released, so the iteration may be
+ *    restarted (ringbuf_frame_consume) without releasing.
+ */
+static void
+frame_put(ringbuf_frame_iter_t *it, size_t pos, size_t end)
+{
+	while (pos < end) {
+		ringbuf_frame_t *f = frame_at(it, pos);
+		const size_t size = frame_size(f);
+
+		if (__predict_false(size > end - pos)) {
+			if (ringbuf_frame_hdrlen(f) <= end - pos) {
+				frame_txn_done(it, f);
+			}
+			break;
+		}
+		frame_txn_done(it, f);
+		if ((f->flags & RINGBUF_FRAME_BLOB) != 0 &&
+		    !frame_corrupt(f, end - pos)) {
+			ASSERT(it->pool != NULL);
+			ringbuf_pool_free(it->pool,
+			    ringbuf_frame_payload(f, it->pool));
+		}
+		pos += size;
+	}
+}
+
+/*
+ * ringbuf_frame_size: return the ring buffer space taken by the record
+ * with the given payload length and options.
+ */
+size_t
+ringbuf_frame_size(size_t len, const ringbuf_frame_opts_t *opts)
+{
+	const ringbuf_frame_t f = {
+		.len = len, .flags = frame_flags(opts, len)
+	};
+	return frame_size(&f);
+}
+
+/*
+ * ringbuf_frame_payload: return the payload of the record, which is
+ * either inline or in the block of the given pool.
+ */
+void *
+ringbuf_frame_payload(ringbuf_frame_t *f, ringbuf_pool_t *pool)
+{
+	if (f->flags & RINGBUF_FRAME_BLOB) {
+		const uint64_t idx = *frame_field(f, RINGBUF_FRAME_BLOB);
+		return ringbuf_pool_block(pool, idx);
+	}
+	return ringbuf_frame_data(f);
+}
+
+static ringbuf_frame_t *
+frame_acquire(ringbuf_t *rbuf, ringbuf_worker_t *w, void *buf, size_t len,
+    unsigned flags, unsigned src, const ringbuf_frame_opts_t *opts)
+{
+	const ringbuf_frame_t hdr = { .len = len, .flags = flags, .src = src };
+	void *blk = NULL;
+	ringbuf_frame_t *f;
+	ssize_t off;
+
+	ASSERT(len <= UINT32_MAX);
+	ASSERT(src <= UINT16_MAX);
+
+	if (__predict_false(frame_size(&hdr) >= ringbuf_get_space(rbuf))) {
+		errno = EMSGSIZE;
+		return NULL;
+	}
+	if (flags & RINGBUF_FRAME_BLOB) {
+		if (__predict_false(len > ringbuf_pool_blksize(opts->pool))) {
+			errno = EMSGSIZE;
+			return NULL;
+		}
+		if ((blk = ringbuf_pool_alloc(opts->pool)) == NULL) {
+			return NULL;
+		}
+	}
+	off = ringbuf_acquire(rbuf, w, frame_size(&hdr));
+	if (off == -1) {
+		if (blk) {
+			ringbuf_pool_free(opts->pool, blk);
+		}
+		return NULL;
+	}
+	f = (void *)((uint8_t *)buf + off);
+	*f = hdr;
+	if (flags & RINGBUF_FRAME_DEADLINE) {
+		*frame_field(f, RINGBUF_FRAME_DEADLINE) = opts->deadline;
+	}
+	if (flags & RINGBUF_FRAME_BLOB) {
+		*frame_field(f, RINGBUF_FRAME_BLOB) =
+		    ringbuf_pool_index(opts->pool, blk);
+	}
+	if (flags & RINGBUF_FRAME_TSTAMP) {
+		*frame_field(f, RINGBUF_FRAME_TSTAMP) = opts->tstamp;
+	}
+	if (flags & RINGBUF_FRAME_TXN) {
+		*frame_field(f, RINGBUF_FRAME_TXN) = opts->txn;
+	}
+	if (flags & RINGBUF_FRAME_KEY) {
+		*frame_field(f, RINGBUF_FRAME_KEY) = opts->key;
+	}
+	return f;
+}
+
+/*
+ * ringbuf_frame_pad: write a padding record filling the given space,
+ * which must be a multiple of RINGBUF_FRAME_ALIGN.
+ */
+void
+ringbuf_frame_pad(void *ptr, size_t size)
+{
+	ringbuf_frame_t *f = ptr;
+
+	ASSERT(size >= sizeof(ringbuf_frame_t));
+	ASSERT(size % RINGBUF_FRAME_ALIGN == 0);
+
+	f->len = size - sizeof(ringbuf_frame_t);
+	f->flags = RINGBUF_FRAME_PAD;
+	f->src = 0;
+}
+
+/*
+ * ringbuf_frame_acquire: acquire the space for a record with the given
+ * payload length and write its header.
+ *
+ * => The 'buf' is the ring buffer data space (aligned to 8 bytes).
+ * => Returns the record, use ringbuf_frame_data() to get the payload
+ *    or ringbuf_frame_payload() if the out-of-line pool is used.
+ * => On failure (not enough space in the ring or pool), returns NULL.
+ *    If the record can never fit (the ring or the pool block is too
+ *    small), errno is set to EMSGSIZE.
+ */
+ringbuf_frame_t *
+ringbuf_frame_acquire(ringbuf_t *rbuf, ringbuf_worker_t *w, void *buf,
+    size_t len, const ringbuf_frame_opts_t *opts)
+{
+	return frame_acquire(rbuf, w, buf, len,
+	    frame_flags(opts, len), 0, opts);
+}
+
+/*
+ * ringbuf_frame_produce: indicate that the record is ready.
+ *
+ * => The checksum, if requested, is computed at this point.
+ */
+void
+ringbuf_frame_produce(ringbuf_t *rbuf, ringbuf_worker_t *w,
+    ringbuf_frame_t *f)
+{
+	if (f->flags & RINGBUF_FRAME_CRC) {
+		*frame_field(f, RINGBUF_FRAME_CRC) = frame_crc(f);
+	}
+	ringbuf_produce(rbuf, w);
+}
+
+/*
+ * ringbuf_frame_produce_durable: compute the checksum and write back
+ * the record using the given persistence mode, then produce it.  The
+ * record must be acquired with the CRC option.
+ *
+ * => Returns 0 on success and -1 on failure (the record not produced).
+ * => The out-of-line payload is not written back.
+ */
+int
+ringbuf_frame_produce_durable(ringbuf_t *rbuf, ringbuf_worker_t *w,
+    ringbuf_frame_t *f, unsigned mode)
+{
+	ASSERT(f->flags & RINGBUF_FRAME_CRC);
+	*frame_field(f, RINGBUF_FRAME_CRC) = frame_crc(f);
+	return ringbuf_produce_durable(rbuf, w, f, frame_size(f), mode);
+}
+
+/*
+ * ringbuf_frame_iter_init: initialise the consumer iterator.
+ */
+void
+ringbuf_frame_iter_init(ringbuf_frame_iter_t *it, ringbuf_t *rbuf, void *buf)
+{
+	memset(it, 0, sizeof(ringbuf_frame_iter_t));
+	it->rbuf = rbuf;
+	it->buf = buf;
+}
+
+/*
+ * ringbuf_frame_iter_setpool: set the pool of the out-of-line payloads.
+ */
+void
+ringbuf_frame_iter_setpool(ringbuf_frame_iter_t *it, ringbuf_pool_t *pool)
+{
+	it->pool = pool;
+}
+
+/*
+ * ringbuf_frame_iter_setpersist: set the persistence mode of the ring
+ * buffer, used when releasing the records.
+ */
+void
+ringbuf_frame_iter_setpersist(ringbuf_frame_iter_t *it, unsigned mode)
+{
+	it->persist = mode;
+}
+
+/*
+ * frame_release: release the given length of the consumed range.  In
+ * the persistence mode, invalidate the records first.  The write-back
+ * errors are ignored: the records may be recovered again after a crash.
+ */
+static void
+frame_release(ringbuf_frame_iter_t *it, size_t nbytes)
+{
+	size_t pos = 0;
+
+	if (it->persist == 0) {
+		ringbuf_release(it->rbuf, nbytes);
+		return;
+	}
+	while (pos < nbytes) {
+		ringbuf_frame_t *f = frame_at(it, pos);
+		const size_t size = frame_size(f);
+
+		memset(f, 0, sizeof(ringbuf_frame_t));
+		if (__predict_false(size > nbytes - pos)) {
+			/* Bogus length: the iteration skipped the rest. */
+			break;
+		}
+		pos += size;
+	}
+	(void)ringbuf_persist_range(frame_at(it, 0), nbytes, it->persist);
+	(void)ringbuf_release_durable(it->rbuf, nbytes, it->persist);
+}
+
+/*
+ * ringbuf_frame_iter_settxn: set the transaction table.  It must be set
+ * if the producers use transactions.
+ */
+void
+ringbuf_frame_iter_settxn(ringbuf_frame_iter_t *it, ringbuf_txn_t *txn)
+{
+	it->txn = txn;
+}
+
+/*
+ * ringbuf_frame_iter_setconflate: set the conflation table.  It must be
+ * set if the producers use ringbuf_conflate_publish().
+ */
+void
+ringbuf_frame_iter_setconflate(ringbuf_frame_iter_t *it,
+    ringbuf_conflate_t *c)
+{
+	it->conflate = c;
+}
+
+/*
+ * ringbuf_frame_consume: get a range of records ready to be consumed.
+ *
+ * => The 'now' is the current time (zero to ignore the deadlines).
+ *    The expired records at the front of the range are released.
+ * => Returns the length of the range or zero if there are no records.
+ */
+size_t
+ringbuf_frame_consume(ringbuf_frame_iter_t *it, uint64_t now)
+{
+	size_t off, len, pos;
+
+	it->now = now;
+again:
+	it->pos = 0;
+	if ((len = ringbuf_consume(it->rbuf, &off)) == 0) {
+		it->len = 0;
+		return 0;
+	}
+	it->off = off;
+	it->len = len;
+
+	/*
+	 * Skip the expired (and padding) records at the front.  Note:
+	 * only the header is inspected.  Release them all at once.
+	 * The records in transactions and the CRC-protected records
+	 * (whose length cannot be trusted before the check) are left
+	 * to the iteration.
+	 */
+	pos = 0;
+	while (pos < len) {
+		const ringbuf_frame_t *f = frame_at(it, pos);
+
+		if ((f->flags & RINGBUF_FRAME_PAD) == 0) {
+			if ((f->flags & (RINGBUF_FRAME_TXN |
+			    RINGBUF_FRAME_CRC)) != 0 ||
+			    !frame_expired(f, now)) {
+				break;
+			}
+			it->nexpired++;
+		}
+		pos += frame_size(f);
+	}
+	if (pos) {
+		ASSERT(pos <= len);
+		if (it->pool) {
+			frame_put(it, 0, pos);
+		}
+		frame_release(it, pos);
+		if (pos == len) {
+			goto again;
+		}
+		it->off += pos;
+		it->len -= pos;
+	}
+	return it->len;
+}
+
+/*
+ * ringbuf_frame_refill: get more records ready to be consumed, while
+ * preserving the iteration position in the current range.
+ *
+ * => Returns the number of bytes remaining to iterate.
+ */
+size_t
+ringbuf_frame_refill(ringbuf_frame_iter_t *it)
+{
+	size_t off, len;
+
+	if (it->pos == 0) {
+		return ringbuf_frame_consume(it, it->now);
+	}
+
+	/*
+	 * Nothing was released since the range was obtained, therefore
+	 * the consumer gets the range at the same offset, possibly longer.
+	 */
+	len = ringbuf_consume(it->rbuf, &off);
+	ASSERT(off == it->off && len >= it->len); (void)off;
+	it->len = len;
+	return it->len - it->pos;
+}
+
+/*
+ * frame_pass: advance the iterator past the record.
+ */
+static inline void
+frame_pass(ringbuf_frame_iter_t *it, const ringbuf_frame_t *f)
+{
+	if (f->flags & RINGBUF_FRAME_BLOB) {
+		it->nblobs++;
+	}
+	it->claimed = false;
+	it->pos += frame_size(f);
+	ASSERT(it->pos <= it->len);
+}
+
+/*
+ * frame_skip: skip the expired, corrupt, aborted, superseded and padding
+ * records and return the record at the iteration position, without
+ * advancing past it.  Stops at the record of an open transaction or
+ * the keyed record which cannot be claimed yet.
+ */
+static ringbuf_frame_t *
+frame_skip(ringbuf_frame_iter_t *it)
+{
+	int claim;
+
+	while (it->pos < it->len) {
+		ringbuf_frame_t *f = frame_at(it, it->pos);
+
+		if (__predict_false(frame_corrupt(f, it->len - it->pos))) {
+			/* If the length is bogus, skip the rest. */
+			it->ncorrupt++;
+			it->pos = frame_size(f) > it->len - it->pos ?
+			    it->len : it->pos + frame_size(f);
+			continue;
+		}
+		if (f->flags & RINGBUF_FRAME_TXN) {
+			const unsigned st = frame_txn(it, f);
+
+			if (st == RINGBUF_TXN_OPEN) {
+				return NULL;
+			}
+			if (st == RINGBUF_TXN_ABORTED) {
+				it->naborted++;
+				frame_pass(it, f);
+				continue;
+			}
+		}
+		if ((f->flags & RINGBUF_FRAME_PAD) == 0) {
+			if (frame_expired(f, it->now)) {
+				it->nexpired++;
+			} else if (it->claimed) {
+				/* Already claimed by a peek. */
+				return f;
+			} else if ((claim = frame_claim(it, f, it->pos)) < 0) {
+				return NULL;
+			} else if (claim == 0) {
+				it->nconflated++;
+			} else {
+				it->claimed = true;
+				return f;
+			}
+		}
+		frame_pass(it, f);
+	}
+	return NULL;
+}
+
+/*
+ * ringbuf_frame_peek: return the next record in the consumed range
+ * without advancing the iterator; NULL if there are no more.
+ */
+ringbuf_frame_t *
+ringbuf_frame_peek(ringbuf_frame_iter_t *it)
+{
+	return frame_skip(it);
+}
+
+/*
+ * ringbuf_frame_next: return the next record in the consumed range,
+ * skipping the expired and padding ones; NULL if there are no more
+ * (or the next record is in an open transaction or its key is being
+ * updated).
+ */
+ringbuf_frame_t *
+ringbuf_frame_next(ringbuf_frame_iter_t *it)
+{
+	ringbuf_frame_t *f;
+
+	if ((f = frame_skip(it)) == NULL) {
+		return NULL;
+	}
+	frame_pass(it, f);
+	return f;
+}
+
+/*
+ * ringbuf_frame_index: index up to 'n' next records in the consumed
+ * range in one pass, advancing the iterator past them.
+ *
+ * => Stores the offsets of the records, relative to the data space,
+ *    so that a batch of records can be processed independently.
+ * => Returns the number of records indexed.
+ */
+size_t
+ringbuf_frame_index(ringbuf_frame_iter_t *it, uint32_t *offs, size_t n)
+{
+	const size_t len = it->len;
+	size_t pos = it->pos, count = 0;
+
+	/*
+	 * Only the headers are read.  The plain records (no flags) take
+	 * the fast path; the others are checked as in frame_skip().
+	 */
+	while (count < n && pos < len) {
+		const ringbuf_frame_t *f = frame_at(it, pos);
+		const unsigned flags = f->flags;
+		const size_t size = frame_size(f);
+
+		if (__predict_false(flags != 0)) {
+			if (frame_corrupt(f, len - pos)) {
+				it->ncorrupt++;
+				pos = size > len - pos ? len : pos + size;
+				continue;
+			}
+			const unsigned st = frame_txn(it, f);
+
+			if (st == RINGBUF_TXN_OPEN) {
+				break;
+			}
+			if (flags & RINGBUF_FRAME_BLOB) {
+				it->nblobs++;
+			}
+			if (st == RINGBUF_TXN_ABORTED) {
+				it->naborted++;
+				pos += size;
+				continue;
+			}
+			if ((flags & RINGBUF_FRAME_PAD) != 0) {
+				pos += size;
+				continue;
+			}
+			if (frame_expired(f, it->now)) {
+				it->nexpired++;
+				pos += size;
+				continue;
+			}
+			if (!(it->claimed && pos == it->pos)) {
+				const int claim = frame_claim(it, f, pos);
+
+				if (claim < 0) {
+					break;
+				}
+				if (claim == 0) {
+					it->nconflated++;
+					pos += size;
+					continue;
+				}
+			}
+		}
+		offs[count++] = it->off + pos;
+		pos += size;
+	}
+	ASSERT(pos <= len);
+	if (pos != it->pos) {
+		it->claimed = false;
+	}
+	it->pos = pos;
+	return count;
+}
+
+/*
+ * ringbuf_frame_release: release the records iterated so far, return
+ * their out-of-line payload blocks, if any, to the pool and pass their
+ * transactions, if any.
+ */
+void
+ringbuf_frame_release(ringbuf_frame_iter_t *it)
+{
+	if (it->pos == 0) {
+		return;
+	}
+	if (it->nblobs || it->txn) {
+		frame_put(it, 0, it->pos);
+		it->nblobs = 0;
+	}
+	frame_release(it, it->pos);
+	it->off += it->pos;
+	it->len -= it->pos;
+	it->pos = 0;
+}
+
+typedef struct {
+	uint8_t *	buf;
+	unsigned	mode;
+	int		error;
+} frame_recover_t;
+
+/*
+ * frame_scan: return the length of the valid records at the given offset
+ * of the data space and clear the rest of the given space.
+ */
+static size_t
+frame_scan(void *arg, size_t off, size_t len)
+{
+	frame_recover_t *rc = arg;
+	size_t pos = 0;
+
+	while (len - pos >= sizeof(ringbuf_frame_t)) {
+		const ringbuf_frame_t *f = (const void *)&rc->buf[off + pos];
+
+		if ((f->flags & RINGBUF_FRAME_CRC) == 0 ||
+		    frame_corrupt(f, len - pos)) {
+			break;
+		}
+		pos += frame_size(f);
+	}
+
+	/*
+	 * The free space may contain the stale records (e.g. following
+	 * an incomplete one), which the new records would not necessarily
+	 * overwrite; clear it.
+	 */
+	if (pos < len) {
+		memset(&rc->buf[off + pos], 0, len - pos);
+		if (ringbuf_persist_range(&rc->buf[off + pos], len - pos,
+		    rc->mode) == -1) {
+			rc->error = errno;
+		}
+	}
+	return pos;
+}
+
+/*
+ * ringbuf_frame_recover: recover the ring buffer with the durably
+ * produced records after a crash (see ringbuf_recover()), using the
+ * given persistence mode.
+ *
+ * => Returns the length of the recovered records or -1 on failure.
+ */
+ssize_t
+ringbuf_frame_recover(ringbuf_t *rbuf, void *buf, unsigned mode)
+{
+	frame_recover_t rc = { .buf = buf, .mode = mode };
+	ssize_t len;
+
+	len = ringbuf_recover(rbuf, frame_scan, &rc);
+	if (rc.error) {
+		errno = rc.error;
+		return -1;
+	}
+	return len;
+}
+
+/*
+ * ringbuf_frag_init: initialise the producer state for the fragmented
+ * messages of the given source, split into chunks of at most 'chunk'
+ * payload bytes.
+ *
+ * => Returns -1 with errno set to EINVAL if a chunk record cannot ever
+ *    fit the ring buffer.
+ */
+int
+ringbuf_frag_init(ringbuf_frag_t *fr, ringbuf_t *rbuf, ringbuf_worker_t *w,
+    void *buf, unsigned src, size_t chunk)
+{
+	if (chunk == 0 || chunk > UINT32_MAX ||
+	    ringbuf_frame_size(chunk, NULL) >= ringbuf_get_space(rbuf)) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(fr, 0, sizeof(ringbuf_frag_t));
+	fr->rbuf = rbuf;
+	fr->w = w;
+	fr->buf = buf;
+	fr->src = src;
+	fr->chunk = chunk;
+	return 0;
+}
+
+/*
+ * ringbuf_frag_begin: start a new message.  The message must remain
+ * valid until ringbuf_frag_write() completes it.
+ */
+void
+ringbuf_frag_begin(ringbuf_frag_t *fr, const void *msg, size_t len)
+{
+	fr->msg = msg;
+	fr->len = len;
+	fr->sent = 0;
+}
+
+/*
+ * ringbuf_frag_write: produce the chunks of the current message, as
+ * many as there is space in the ring buffer.
+ *
+ * => Returns 0 if the whole message was produced.
+ * => Returns -1 and sets errno to EAGAIN if the ring buffer is full;
+ *    the caller should retry once the consumer makes progress.
+ */
+int
+ringbuf_frag_write(ringbuf_frag_t *fr)
+{
+	do {
+		const size_t n = MIN(fr->chunk, fr->len - fr->sent);
+		unsigned flags = RINGBUF_FRAME_FRAG;
+		ringbuf_frame_t *f;
+
+		if (fr->sent == 0) {
+			flags |= RINGBUF_FRAME_FIRST;
+		}
+		if (fr->sent + n == fr->len) {
+			flags |= RINGBUF_FRAME_LAST;
+		}
+		f = frame_acquire(fr->rbuf, fr->w, fr->buf, n,
+		    flags, fr->src, NULL);
+		if (f == NULL) {
+			errno = EAGAIN;
+			return -1;
+		}
+		if (n) {
+			memcpy(ringbuf_frame_data(f), fr->msg + fr->sent, n);
+		}
+		ringbuf_produce(fr->rbuf, fr->w);
+		fr->sent += n;
+	} while (fr->sent < fr->len);
+
+	return 0;
+}
+
+/*
+ * ringbuf_reasm_create: construct the reassembly state for the given
+ * number of sources.
+ */
+ringbuf_reasm_t *
+ringbuf_reasm_create(unsigned nsrc)
+{
+	ringbuf_reasm_t *ra;
+
+	ASSERT(nsrc <= UINT16_MAX + 1);
+	ra = calloc(1, offsetof(ringbuf_reasm_t, src[nsrc]));
+	if (ra == NULL) {
+		return NULL;
+	}
+	ra->nsrc = nsrc;
+	return ra;
+}
+
+void
+ringbuf_reasm_destroy(ringbuf_reasm_t *ra)
+{
+	for (unsigned i = 0; i < ra->nsrc; i++) {
+		free(ra->src[i].buf);
+	}
+	free(ra);
+}
+
+/*
+ * ringbuf_reasm_push: feed the consumed record into the reassembly.
+ *
+ * => Returns the complete message and its length, if this record
+ *    completes it; otherwise, returns NULL.  The message is valid
+ *    until the next call for the same source (or until the record
+ *    is released, if the message was not fragmented).
+ * => Chunks without the preceding first chunk are dropped.
+ */
+void *
+ringbuf_reasm_push(ringbuf_reasm_t *ra, ringbuf_frame_t *f, size_t *lenp)
+{
+	const unsigned flags = f->flags;
+	struct reasm_src *s;
+	size_t len;
+
+	/*
+	 * Not fragmented or the whole message in a single chunk:
+	 * just return the payload in place.
+	 */
+	if ((flags & RINGBUF_FRAME_FRAG) == 0 ||
+	    (flags & (RINGBUF_FRAME_FIRST | RINGBUF_FRAME_LAST)) ==
+	    (RINGBUF_FRAME_FIRST | RINGBUF_FRAME_LAST)) {
+		*lenp = f->len;
+		return ringbuf_frame_data(f);
+	}
+
+	ASSERT(f->src < ra->nsrc);
+	s = &ra->src[f->src];
+	if (flags & RINGBUF_FRAME_FIRST) {
+		s->len = 0;
+		s->active = true;
+	}
+	if (!s->active) {
+		return NULL;
+	}
+
+	/* Append the chunk, growing the buffer if necessary. */
+	len = s->len + f->len;
+	if (len > s->cap) {
+		const size_t cap = MAX(len, s->cap * 2);
+		uint8_t *buf;
+
+		if ((buf = realloc(s->buf, cap)) == NULL) {
+			s->active = false;
+			return NULL;
+		}
+		s->buf = buf;
+		s->cap = cap;
+	}
+	if (f->len) {
+		memcpy(s->buf + s->len, ringbuf_frame_data(f), f->len);
+	}
+	s->len = len;
+
+	if ((flags & RINGBUF_FRAME_LAST) == 0) {
+		return NULL;
+	}
+	s->active = false;
+	*lenp = s->len;
+	return s->buf;
+}
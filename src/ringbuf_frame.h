@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_FRAME_H_
+#define _RINGBUF_FRAME_H_
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include "ringbuf.h"
+#include "ringbuf_pool.h"
+
+__BEGIN_DECLS
+
+/*
+ * The framed record: the header is followed by the optional 64-bit
+ * fields (present in the order of their flag bits) and the payload.
+ * All records are aligned to RINGBUF_FRAME_ALIGN.
+ */
+typedef struct {
+	uint32_t	len;		/* payload length */
+	uint16_t	flags;
+	uint16_t	src;		/* source ID (fragmented messages) */
+} ringbuf_frame_t;
+
+#define	RINGBUF_FRAME_ALIGN	8
+
+/* Optional fields. */
+#define	RINGBUF_FRAME_DEADLINE	0x0001	/* expiry time */
+#define	RINGBUF_FRAME_BLOB	0x0002	/* out-of-line payload block */
+#define	RINGBUF_FRAME_TSTAMP	0x0004	/* timestamp (merge order) */
+#define	RINGBUF_FRAME_CRC	0x0008	/* CRC32C of the record */
+#define	RINGBUF_FRAME_TXN	0x0010	/* transaction ID */
+#define	RINGBUF_FRAME_KEY	0x0020	/* conflation key */
+#define	RINGBUF_FRAME_OPTMASK	0x00ff
+
+/* Fragments (chunks) of a message. */
+#define	RINGBUF_FRAME_FRAG	0x0100	/* record is a chunk */
+#define	RINGBUF_FRAME_FIRST	0x0200	/* first chunk */
+#define	RINGBUF_FRAME_LAST	0x0400	/* last chunk */
+
+/* Padding: unused space, skipped by the consumer. */
+#define	RINGBUF_FRAME_PAD	0x0800
+
+/* The payload was truncated (see ringbuf_ingest.c). */
+#define	RINGBUF_FRAME_TRUNC	0x1000
+
+typedef struct {
+	uint64_t	deadline;	/* expiry time; zero if none */
+	ringbuf_pool_t *pool;		/* pool for the out-of-line payloads */
+	size_t		indirect;	/* .. of at least this length */
+	uint64_t	tstamp;		/* timestamp; zero if none */
+	bool		crc;		/* protect the record with CRC32C */
+	uint64_t	txn;		/* transaction ID (see ringbuf_txn.c) */
+	bool		keyed;		/* carry the conflation key */
+	uint64_t	key;		/* .. (see ringbuf_conflate.c) */
+} ringbuf_frame_opts_t;
+
+typedef struct ringbuf_txn ringbuf_txn_t;
+typedef struct ringbuf_conflate ringbuf_conflate_t;
+
+typedef struct {
+	ringbuf_t *	rbuf;
+	uint8_t *	buf;
+	size_t		off;		/* consumed range */
+	size_t		len;
+	size_t		pos;		/* iteration position in the range */
+	uint64_t	now;
+	uint64_t	nexpired;	/* expired records dropped */
+	uint64_t	ncorrupt;	/* records failing the CRC check */
+	ringbuf_pool_t *pool;
+	size_t		nblobs;		/* out-of-line records iterated */
+	unsigned	persist;	/* persistence mode; zero if none */
+	ringbuf_txn_t *	txn;		/* transaction table */
+	uint64_t	naborted;	/* records of aborted transactions */
+	ringbuf_conflate_t *conflate;	/* conflation table */
+	bool		claimed;	/* .. the record at 'pos' is claimed */
+	uint64_t	nconflated;	/* superseded records dropped */
+} ringbuf_frame_iter_t;
+
+/*
+ * The producer state of a fragmented message.
+ */
+typedef struct {
+	ringbuf_t *		rbuf;
+	ringbuf_worker_t *	w;
+	void *			buf;
+	const uint8_t *		msg;
+	size_t			len;
+	size_t			sent;
+	size_t			chunk;
+	unsigned		src;
+} ringbuf_frag_t;
+
+typedef struct ringbuf_reasm ringbuf_reasm_t;
+
+static inline const uint64_t *
+ringbuf_frame_field(const ringbuf_frame_t *f, unsigned flag)
+{
+	const unsigned idx = __builtin_popcount(f->flags &
+	    RINGBUF_FRAME_OPTMASK & (flag - 1));
+	return (const uint64_t *)(const void *)(f + 1) + idx;
+}
+
+static inline size_t
+ringbuf_frame_hdrlen(const ringbuf_frame_t *f)
+{
+	return sizeof(ringbuf_frame_t) + sizeof(uint64_t) *
+	    __builtin_popcount(f->flags & RINGBUF_FRAME_OPTMASK);
+}
+
+static inline void *
+ringbuf_frame_data(ringbuf_frame_t *f)
+{
+	return (uint8_t *)f + ringbuf_frame_hdrlen(f);
+}
+
+static inline uint64_t
+ringbuf_frame_deadline(const ringbuf_frame_t *f)
+{
+	return (f->flags & RINGBUF_FRAME_DEADLINE) ?
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_DEADLINE) : 0;
+}
+
+static inline uint64_t
+ringbuf_frame_tstamp(const ringbuf_frame_t *f)
+{
+	return (f->flags & RINGBUF_FRAME_TSTAMP) ?
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_TSTAMP) : 0;
+}
+
+static inline uint64_t
+ringbuf_frame_key(const ringbuf_frame_t *f)
+{
+	return (f->flags & RINGBUF_FRAME_KEY) ?
+	    *ringbuf_frame_field(f, RINGBUF_FRAME_KEY) : 0;
+}
+
+size_t		ringbuf_frame_size(size_t, const ringbuf_frame_opts_t *);
+void *		ringbuf_frame_payload(ringbuf_frame_t *, ringbuf_pool_t *);
+void		ringbuf_frame_pad(void *, size_t);
+
+ringbuf_frame_t *ringbuf_frame_acquire(ringbuf_t *, ringbuf_worker_t *,
+		    void *, size_t, const ringbuf_frame_opts_t *);
+void		ringbuf_frame_produce(ringbuf_t *, ringbuf_worker_t *,
+		    ringbuf_frame_t *);
+int		ringbuf_frame_produce_durable(ringbuf_t *, ringbuf_worker_t *,
+		    ringbuf_frame_t *, unsigned);
+
+void		ringbuf_frame_iter_init(ringbuf_frame_iter_t *,
+		    ringbuf_t *, void *);
+void		ringbuf_frame_iter_setpool(ringbuf_frame_iter_t *,
+		    ringbuf_pool_t *);
+void		ringbuf_frame_iter_setpersist(ringbuf_frame_iter_t *,
+		    unsigned);
+void		ringbuf_frame_iter_settxn(ringbuf_frame_iter_t *,
+		    ringbuf_txn_t *);
+void		ringbuf_frame_iter_setconflate(ringbuf_frame_iter_t *,
+		    ringbuf_conflate_t *);
+size_t		ringbuf_frame_consume(ringbuf_frame_iter_t *, uint64_t);
+size_t		ringbuf_frame_refill(ringbuf_frame_iter_t *);
+ringbuf_frame_t *ringbuf_frame_peek(ringbuf_frame_iter_t *);
+ringbuf_frame_t *ringbuf_frame_next(ringbuf_frame_iter_t *);
+size_t		ringbuf_frame_index(ringbuf_frame_iter_t *, uint32_t *, size_t);
+void		ringbuf_frame_release(ringbuf_frame_iter_t *);
+ssize_t		ringbuf_frame_recover(ringbuf_t *, void *, unsigned);
+
+int		ringbuf_frag_init(ringbuf_frag_t *, ringbuf_t *,
+		    ringbuf_worker_t *, void *, unsigned, size_t);
+void		ringbuf_frag_begin(ringbuf_frag_t *, const void *, size_t);
+int		ringbuf_frag_write(ringbuf_frag_t *);
+
+ringbuf_reasm_t *ringbuf_reasm_create(unsigned);
+void		ringbuf_reasm_destroy(ringbuf_reasm_t *);
+void *		ringbuf_reasm_push(ringbuf_reasm_t *, ringbuf_frame_t *,
+		    size_t *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Batched ingest of the datagrams directly into the ring buffer.
+ *
+ * A batch of the maximum-size framed records is acquired in one go and
+ * the I/O vectors of recvmmsg(2) point straight at their payloads, thus
+ * avoiding a copy per packet.  Once received, the header of each record
+ * is set to the actual datagram length.  The ring buffer reservation
+ * cannot be shrunk (other producers might have acquired the space after
+ * it), therefore the unused tail of each slot and the slots left empty
+ * become the padding records, which the consumer skips looking only at
+ * their headers.  The whole batch is produced at once.
+ *
+ * The space is acquired only once a datagram is queued: an empty poll
+ * must not waste the ring with padding and, in the blocking mode, the
+ * unproduced reservation must not be held while sleeping, as it would
+ * stall the consumer (and hence all other producers).
+ *
+ * A datagram larger than 'maxlen' is stored cut short, with the record
+ * flagged as RINGBUF_FRAME_TRUNC, so that the consumer can tell.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_ingest.h"
+#include "ringbuf_frame.h"
+#include "utils.h"
+
+#if !defined(__linux__)
+/*
+ * Fallback: receive the datagrams one by one (still without a copy).
+ */
+struct mmsghdr {
+	struct msghdr	msg_hdr;
+	unsigned	msg_len;
+};
+
+static int
+recvmmsg(int fd, struct mmsghdr *msgs, unsigned n, int flags, void *tmo)
+{
+	unsigned i;
+
+	for (i = 0; i < n; i++) {
+		ssize_t ret;
+
+		if ((ret = recvmsg(fd, &msgs[i].msg_hdr, flags)) == -1) {
+			return i ? (int)i : -1;
+		}
+		msgs[i].msg_len = ret;
+		flags |= MSG_DONTWAIT;
+	}
+	(void)tmo;
+	return i;
+}
+#endif
+
+/*
+ * ringbuf_ingest_dgram: receive up to 'nmsg' datagrams of at most 'maxlen'
+ * bytes from the socket and produce them as the framed records.
+ *
+ * => The 'flags' are passed to recvmmsg(2), e.g. MSG_DONTWAIT; without
+ *    it, waits for a datagram before touching the ring buffer.
+ * => The batch is clamped to fit the ring buffer; if there is not enough
+ *    space for the whole batch, a smaller batch is attempted.
+ * => Returns the number of datagrams ingested (zero if none available
+ *    in the non-blocking mode).  On failure, returns -1 and sets errno;
+ *    ENOBUFS indicates that the ring buffer is full and EINVAL that even
+ *    a single record of 'maxlen' bytes cannot fit it.
+ */
+ssize_t
+ringbuf_ingest_dgram(ringbuf_t *rbuf, ringbuf_worker_t *w, void *buf,
+    int fd, unsigned nmsg, size_t maxlen, int flags)
+{
+	const size_t slot = ringbuf_frame_size(maxlen, NULL);
+	struct mmsghdr msgs[RINGBUF_INGEST_MAX];
+	struct iovec iov[RINGBUF_INGEST_MAX];
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	uint8_t *base;
+	ssize_t off;
+	int n, error;
+
+	ASSERT(nmsg > 0 && nmsg <= RINGBUF_INGEST_MAX);
+
+	if (maxlen > UINT32_MAX || slot >= ringbuf_get_space(rbuf)) {
+		errno = EINVAL;
+		return -1;
+	}
+	nmsg = MIN(nmsg, (ringbuf_get_space(rbuf) - 1) / slot);
+
+	/*
+	 * Note: with MSG_TRUNC, the length returned would be the real
+	 * length of the datagram, which may exceed the slot.
+	 */
+	flags &= ~MSG_TRUNC;
+
+	/*
+	 * Wait for a datagram (or an error) to be queued.
+	 */
+	while ((n = poll(&pfd, 1, (flags & MSG_DONTWAIT) ? 0 : -1)) == -1) {
+		if (errno != EINTR) {
+			return -1;
+		}
+	}
+	if (n == 0) {
+		return 0;
+	}
+
+	/*
+	 * Acquire the space for the whole batch with a single call.
+	 */
+	while ((off = ringbuf_acquire(rbuf, w, nmsg * slot)) == -1) {
+		if ((nmsg /= 2) == 0) {
+			errno = ENOBUFS;
+			return -1;
+		}
+	}
+	base = (uint8_t *)buf + off;
+
+	memset(msgs, 0, sizeof(struct mmsghdr) * nmsg);
+	for (unsigned i = 0; i < nmsg; i++) {
+		iov[i].iov_base = base + i * slot + sizeof(ringbuf_frame_t);
+		iov[i].iov_len = maxlen;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	/* Note: must not block while holding the reservation. */
+	n = recvmmsg(fd, msgs, nmsg, flags | MSG_DONTWAIT, NULL);
+	error = errno;
+
+	/*
+	 * Set the actual lengths and pad the unused space.
+	 */
+	for (int i = 0; i < n; i++) {
+		ringbuf_frame_t *f = (void *)(base + i * slot);
+		size_t fsize;
+
+		f->len = MIN(msgs[i].msg_len, maxlen);
+		f->flags = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ?
+		    RINGBUF_FRAME_TRUNC : 0;
+		f->src = 0;
+
+		fsize = ringbuf_frame_size(f->len, NULL);
+		if (fsize < slot) {
+			ringbuf_frame_pad((uint8_t *)f + fsize, slot - fsize);
+		}
+	}
+	if ((unsigned)MAX(n, 0) < nmsg) {
+		const unsigned i = MAX(n, 0);
+		ringbuf_frame_pad(base + i * slot, (nmsg - i) * slot);
+	}
+	ringbuf_produce(rbuf, w);
+
+	if (n == -1) {
+		if (error == EAGAIN || error == EWOULDBLOCK) {
+			return 0;
+		}
+		errno = error;
+		return -1;
+	}
+	return n;
+}
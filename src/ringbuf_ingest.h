@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_INGEST_H_
+#define _RINGBUF_INGEST_H_
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+/* Maximum number of datagrams received in a batch. */
+#define	RINGBUF_INGEST_MAX	64
+
+ssize_t		ringbuf_ingest_dgram(ringbuf_t *, ringbuf_worker_t *,
+		    void *, int, unsigned, size_t, int);
+
+__END_DECLS
+
+#endif
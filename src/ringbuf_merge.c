@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Timestamp-ordered merge of the framed records of multiple rings.
+ *
+ * Each ring (e.g. per CPU or per tenant) has its own frame iterator.
+ * The head record of every non-empty ring is peeked at and the ring
+ * is placed on a binary min-heap keyed by the head record timestamp.
+ * The merge yields the head of the ring at the top of the heap; the
+ * ring is put back on the heap with its next head on the next call.
+ *
+ * The iterated records are not released one by one: the caller calls
+ * ringbuf_merge_release() once it is done with a batch, releasing the
+ * consumed range of each ring at once.  The records are valid until
+ * then.  Note: a ring cannot wrap around until its range is released,
+ * therefore the batches should be bounded.
+ *
+ * Empty rings
+ *
+ *	By default, the empty rings are simply ignored, i.e. the order is
+ *	global only among the records available at the time of the merge.
+ *	In the strict mode, no records are yielded while any of the rings
+ *	is empty, since it could still produce an older record.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <limits.h>
+
+#include "ringbuf_merge.h"
+#include "utils.h"
+
+#define	MERGE_NONE		UINT_MAX
+
+struct ringbuf_merge {
+	unsigned		nrings;
+	unsigned		flags;
+	unsigned		nheap;
+	unsigned		last;
+	unsigned *		heap;
+	struct merge_ring {
+		ringbuf_frame_iter_t it;
+		uint64_t	key;
+		bool		queued;
+		bool		active;
+	} ring[];
+};
+
+/*
+ * ringbuf_merge_create: construct the merge of the given number of
+ * rings; they must be added using ringbuf_merge_add().
+ */
+ringbuf_merge_t *
+ringbuf_merge_create(unsigned nrings, unsigned flags)
+{
+	ringbuf_merge_t *m;
+
+	m = calloc(1, offsetof(ringbuf_merge_t, ring[nrings]));
+	if (m == NULL) {
+		return NULL;
+	}
+	m->heap = calloc(nrings ? nrings : 1, sizeof(unsigned));
+	if (m->heap == NULL) {
+		free(m);
+		return NULL;
+	}
+	m->nrings = nrings;
+	m->flags = flags;
+	m->last = MERGE_NONE;
+	return m;
+}
+
+void
+ringbuf_merge_destroy(ringbuf_merge_t *m)
+{
+	free(m->heap);
+	free(m);
+}
+
+/*
+ * ringbuf_merge_add: set the ring buffer and its data space for the
+ * given index.  Returns the iterator, e.g. to set the pool.
+ */
+ringbuf_frame_iter_t *
+ringbuf_merge_add(ringbuf_merge_t *m, unsigned i, ringbuf_t *rbuf, void *buf)
+{
+	struct merge_ring *r = &m->ring[i];
+
+	ASSERT(i < m->nrings);
+	ringbuf_frame_iter_init(&r->it, rbuf, buf);
+	r->active = true;
+	return &r->it;
+}
+
+static inline bool
+merge_less(const ringbuf_merge_t *m, unsigned a, unsigned b)
+{
+	return m->ring[m->heap[a]].key < m->ring[m->heap[b]].key;
+}
+
+static inline void
+merge_swap(ringbuf_merge_t *m, unsigned a, unsigned b)
+{
+	const unsigned tmp = m->heap[a];
+
+	m->heap[a] = m->heap[b];
+	m->heap[b] = tmp;
+}
+
+static void
+merge_push(ringbuf_merge_t *m, unsigned i)
+{
+	unsigned pos = m->nheap++;
+
+	ASSERT(!m->ring[i].queued);
+	m->ring[i].queued = true;
+	m->heap[pos] = i;
+	while (pos) {
+		const unsigned parent = (pos - 1) / 2;
+
+		if (!merge_less(m, pos, parent)) {
+			break;
+		}
+		merge_swap(m, pos, parent);
+		pos = parent;
+	}
+}
+
+static unsigned
+merge_pop(ringbuf_merge_t *m)
+{
+	const unsigned top = m->heap[0];
+	unsigned pos = 0;
+
+	ASSERT(m->nheap > 0);
+	m->heap[0] = m->heap[--m->nheap];
+	for (;;) {
+		const unsigned l = 2 * pos + 1, r = l + 1;
+		unsigned min = pos;
+
+		if (l < m->nheap && merge_less(m, l, min)) {
+			min = l;
+		}
+		if (r < m->nheap && merge_less(m, r, min)) {
+			min = r;
+		}
+		if (min == pos) {
+			break;
+		}
+		merge_swap(m, pos, min);
+		pos = min;
+	}
+	m->ring[top].queued = false;
+	return top;
+}
+
+/*
+ * merge_fetch: peek at the head record of the ring, getting more records
+ * if the consumed range is exhausted, and queue the ring on the heap.
+ */
+static bool
+merge_fetch(ringbuf_merge_t *m, unsigned i)
+{
+	struct merge_ring *r = &m->ring[i];
+	const ringbuf_frame_t *f;
+
+	if ((f = ringbuf_frame_peek(&r->it)) == NULL) {
+		if (ringbuf_frame_refill(&r->it) == 0 ||
+		    (f = ringbuf_frame_peek(&r->it)) == NULL) {
+			return false;
+		}
+	}
+	r->key = ringbuf_frame_tstamp(f);
+	merge_push(m, i);
+	return true;
+}
+
+/*
+ * ringbuf_merge_next: return the record with the lowest timestamp among
+ * the head records of the rings and set the index of its ring.
+ *
+ * => Returns NULL if there are no records (or, in the strict mode, if
+ *    any of the rings is empty).
+ * => The record is valid until ringbuf_merge_release() is called.
+ */
+ringbuf_frame_t *
+ringbuf_merge_next(ringbuf_merge_t *m, unsigned *ringp)
+{
+	const bool strict = (m->flags & RINGBUF_MERGE_STRICT) != 0;
+	ringbuf_frame_t *f;
+	unsigned i;
+
+	/*
+	 * Queue the rings without the head record: the ring of the last
+	 * yielded record and the rings which were empty.
+	 */
+	if (m->last != MERGE_NONE) {
+		(void)merge_fetch(m, m->last);
+		m->last = MERGE_NONE;
+	}
+	if (m->nheap < m->nrings) {
+		bool empty = false;
+
+		for (i = 0; i < m->nrings; i++) {
+			const struct merge_ring *r = &m->ring[i];
+
+			if (r->active && !r->queued && !merge_fetch(m, i)) {
+				empty = true;
+			}
+		}
+		if (empty && strict) {
+			return NULL;
+		}
+	}
+	if (m->nheap == 0) {
+		return NULL;
+	}
+
+	i = merge_pop(m);
+	f = ringbuf_frame_next(&m->ring[i].it);
+	ASSERT(f != NULL);
+	m->last = i;
+	*ringp = i;
+	return f;
+}
+
+/*
+ * ringbuf_merge_release: release the records yielded so far, in bulk
+ * for each ring.
+ */
+void
+ringbuf_merge_release(ringbuf_merge_t *m)
+{
+	for (unsigned i = 0; i < m->nrings; i++) {
+		struct merge_ring *r = &m->ring[i];
+
+		if (r->active) {
+			ringbuf_frame_release(&r->it);
+		}
+	}
+}
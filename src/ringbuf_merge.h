@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_MERGE_H_
+#define _RINGBUF_MERGE_H_
+
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_merge ringbuf_merge_t;
+
+/* Do not yield records while any of the rings is empty. */
+#define	RINGBUF_MERGE_STRICT	0x01
+
+ringbuf_merge_t *ringbuf_merge_create(unsigned, unsigned);
+void		ringbuf_merge_destroy(ringbuf_merge_t *);
+ringbuf_frame_iter_t *ringbuf_merge_add(ringbuf_merge_t *, unsigned,
+		    ringbuf_t *, void *);
+
+ringbuf_frame_t *ringbuf_merge_next(ringbuf_merge_t *, unsigned *);
+void		ringbuf_merge_release(ringbuf_merge_t *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Work-stealing consumers over a partitioned set of rings.
+ *
+ * Each partition is a ring with its home consumer.  Under a skewed load,
+ * an idle consumer may steal: take over the consumption of the most
+ * loaded ring of another partition, drain a bounded batch and hand it
+ * back.  The ring buffer has a single consumer at a time, therefore the
+ * consumer side of each ring is guarded by an ownership word, which is
+ * acquired using CAS by the home consumer and the stealers alike; the
+ * attempt fails (rather than waits) if the ring is owned.
+ *
+ * The owner processes the records of its batch and releases them before
+ * handing the ring back, i.e. the records of a partition are processed
+ * in the FIFO order, one batch at a time.  The iterator of the ring is
+ * passed along with the ownership.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "ringbuf_part.h"
+#include "utils.h"
+
+struct ringbuf_part {
+	unsigned		nparts;
+	unsigned		batch;
+	uint8_t			_pad[CACHE_LINE_SIZE - 2 * sizeof(unsigned)];
+	struct part_ring {
+		volatile uint32_t	owner;
+		bool			active;
+		volatile uint64_t	nstolen; /* records taken by stealers */
+		ringbuf_frame_iter_t	it;
+	} ring[];
+};
+
+/*
+ * ringbuf_part_create: construct the set of the given number of
+ * partitions, draining up to 'batch' records at a time.
+ */
+ringbuf_part_t *
+ringbuf_part_create(unsigned nparts, unsigned batch)
+{
+	ringbuf_part_t *p;
+
+	if (batch == 0) {
+		return NULL;
+	}
+	p = calloc(1, offsetof(ringbuf_part_t, ring[nparts]));
+	if (p == NULL) {
+		return NULL;
+	}
+	p->nparts = nparts;
+	p->batch = batch;
+	return p;
+}
+
+void
+ringbuf_part_destroy(ringbuf_part_t *p)
+{
+	free(p);
+}
+
+/*
+ * ringbuf_part_add: set the ring buffer and its data space for the given
+ * partition.  Returns the iterator, e.g. to set the pool.
+ */
+ringbuf_frame_iter_t *
+ringbuf_part_add(ringbuf_part_t *p, unsigned i, ringbuf_t *rbuf, void *buf)
+{
+	struct part_ring *r = &p->ring[i];
+
+	ASSERT(i < p->nparts);
+	ringbuf_frame_iter_init(&r->it, rbuf, buf);
+	r->active = true;
+	return &r->it;
+}
+
+/*
+ * part_drain: take the ownership of the ring, process a batch of its
+ * records and hand it back.  Returns the number of records processed;
+ * zero if there are none or the ring is owned by another consumer.
+ */
+static unsigned
+part_drain(ringbuf_part_t *p, unsigned i, bool steal,
+    ringbuf_part_handler_t handler, void *arg)
+{
+	struct part_ring *r = &p->ring[i];
+	ringbuf_frame_t *f;
+	uint32_t owner = 0;
+	unsigned n = 0;
+
+	if (!r->active || atomic_load_explicit(&r->owner,
+	    memory_order_relaxed) != 0) {
+		return 0;
+	}
+	if (!atomic_compare_exchange_weak(&r->owner, &owner, 1)) {
+		return 0;
+	}
+	if (ringbuf_frame_consume(&r->it, 0)) {
+		while (n < p->batch && (f = ringbuf_frame_next(&r->it)) != NULL) {
+			handler(arg, i, f);
+			n++;
+		}
+		ringbuf_frame_release(&r->it);
+	}
+	if (steal) {
+		r->nstolen += n;
+	}
+	atomic_store_explicit(&r->owner, 0, memory_order_release);
+	return n;
+}
+
+/*
+ * ringbuf_part_drain: process a batch of records of the given partition,
+ * invoking the handler for each record.
+ *
+ * => Returns the number of records processed; zero if there are none or
+ *    the ring is being drained by a stealer.
+ */
+unsigned
+ringbuf_part_drain(ringbuf_part_t *p, unsigned i,
+    ringbuf_part_handler_t handler, void *arg)
+{
+	ASSERT(i < p->nparts);
+	return part_drain(p, i, false, handler, arg);
+}
+
+/*
+ * ringbuf_part_steal: process a batch of records of the most loaded
+ * partition other than the given one, e.g. when its own ring is empty.
+ *
+ * => Returns the number of records processed.
+ */
+unsigned
+ringbuf_part_steal(ringbuf_part_t *p, unsigned self,
+    ringbuf_part_handler_t handler, void *arg)
+{
+	unsigned victim = self;
+	size_t max = 0;
+
+	for (unsigned i = 0; i < p->nparts; i++) {
+		const struct part_ring *r = &p->ring[i];
+		size_t usage;
+
+		if (i == self || !r->active || atomic_load_explicit(
+		    &r->owner, memory_order_relaxed) != 0) {
+			continue;
+		}
+		if ((usage = ringbuf_get_usage(r->it.rbuf)) > max) {
+			max = usage;
+			victim = i;
+		}
+	}
+	if (victim == self) {
+		return 0;
+	}
+	return part_drain(p, victim, true, handler, arg);
+}
+
+/*
+ * ringbuf_part_nstolen: return the number of records of the partition
+ * processed by the stealers.
+ */
+uint64_t
+ringbuf_part_nstolen(const ringbuf_part_t *p, unsigned i)
+{
+	ASSERT(i < p->nparts);
+	return atomic_load_explicit(&p->ring[i].nstolen, memory_order_relaxed);
+}
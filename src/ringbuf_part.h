@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_PART_H_
+#define _RINGBUF_PART_H_
+
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_part ringbuf_part_t;
+
+typedef void (*ringbuf_part_handler_t)(void *, unsigned, ringbuf_frame_t *);
+
+ringbuf_part_t *ringbuf_part_create(unsigned, unsigned);
+void		ringbuf_part_destroy(ringbuf_part_t *);
+ringbuf_frame_iter_t *ringbuf_part_add(ringbuf_part_t *, unsigned,
+		    ringbuf_t *, void *);
+
+unsigned	ringbuf_part_drain(ringbuf_part_t *, unsigned,
+		    ringbuf_part_handler_t, void *);
+unsigned	ringbuf_part_steal(ringbuf_part_t *, unsigned,
+		    ringbuf_part_handler_t, void *);
+uint64_t	ringbuf_part_nstolen(const ringbuf_part_t *, unsigned);
+
+__END_DECLS
+
+#endif
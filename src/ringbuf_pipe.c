@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Multi-stage pipeline over a single ring buffer.
+ *
+ * The records are written once and processed in place by a sequence
+ * of stages (e.g. decode, enrich, write), each typically running on
+ * its own thread.  Every stage has a cursor: the offset up to which
+ * it has processed the data.
+ *
+ * - The first stage is the consumer of the ring buffer: it obtains
+ *   the ready range, starting at its cursor.
+ *
+ * - Any other stage may only advance up to the cursor of the previous
+ *   stage.  The cursor is published with a release barrier, so that
+ *   the next stage observes the in-place modifications.
+ *
+ * - The cursor of the last stage drives the release.  Since the
+ *   release must not race with the consume, it is performed by the
+ *   first stage, on its next ringbuf_pipe_get() call.
+ *
+ * Wrap-around
+ *
+ *	The consumer cannot wrap around until the whole range up to the
+ *	'end' offset is released, i.e. processed by all stages; therefore,
+ *	the stages are at most one lap apart and, when the previous stage
+ *	enters the next lap, the stage is at the end of the data and can
+ *	continue from the beginning of the buffer.  The cursors carry the
+ *	lap number in the upper 32 bits to tell the laps apart.
+ *
+ *	The first stage detects the wrap-around of the consumer as the
+ *	range not starting at the offset it has released up to.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "ringbuf_pipe.h"
+#include "utils.h"
+
+#define	CURSOR(lap, off)	(((uint64_t)(lap) << 32) | (off))
+#define	CURSOR_LAP(c)		((uint32_t)((c) >> 32))
+#define	CURSOR_OFF(c)		((size_t)((c) & 0xffffffffUL))
+
+struct ringbuf_pipe {
+	ringbuf_t *		rbuf;
+	unsigned		nstages;
+	size_t			released; /* by the first stage */
+	uint8_t			_pad[CACHE_LINE_SIZE - sizeof(ringbuf_t *) -
+				    sizeof(unsigned) - sizeof(size_t)];
+	struct pipe_stage {
+		volatile uint64_t cursor; /* published lap and offset */
+		size_t		pos;	/* start of the current range */
+		size_t		len;	/* .. and its length */
+		uint32_t	lap;
+		uint8_t		_pad[CACHE_LINE_SIZE - sizeof(uint64_t) -
+				    2 * sizeof(size_t) - sizeof(uint32_t)];
+	} stage[];
+};
+
+/*
+ * ringbuf_pipe_create: construct the pipeline of the given number of
+ * stages over the ring buffer; the stages are numbered from zero.
+ */
+ringbuf_pipe_t *
+ringbuf_pipe_create(ringbuf_t *rbuf, unsigned nstages)
+{
+	ringbuf_pipe_t *p;
+
+	if (nstages == 0) {
+		return NULL;
+	}
+	p = calloc(1, offsetof(ringbuf_pipe_t, stage[nstages]));
+	if (p == NULL) {
+		return NULL;
+	}
+	p->rbuf = rbuf;
+	p->nstages = nstages;
+	return p;
+}
+
+void
+ringbuf_pipe_destroy(ringbuf_pipe_t *p)
+{
+	free(p);
+}
+
+/*
+ * pipe_consume: release the range processed by the last stage and get
+ * the ready range for the first stage.
+ */
+static size_t
+pipe_consume(ringbuf_pipe_t *p, struct pipe_stage *st)
+{
+	const uint64_t last = atomic_load_explicit(
+	    &p->stage[p->nstages - 1].cursor, memory_order_acquire);
+	size_t off, len;
+
+	/*
+	 * The last stage may still be in the previous lap, but then it
+	 * has nothing more to release.
+	 */
+	if (CURSOR_LAP(last) == st->lap && CURSOR_OFF(last) > p->released) {
+		ringbuf_release(p->rbuf, CURSOR_OFF(last) - p->released);
+		p->released = CURSOR_OFF(last);
+	}
+	if ((len = ringbuf_consume(p->rbuf, &off)) == 0) {
+		return 0;
+	}
+	if (off != p->released) {
+		/* The consumer wrapped around. */
+		ASSERT(off == 0);
+		p->released = 0;
+		st->pos = 0;
+		st->lap++;
+	}
+	ASSERT(st->pos >= off && st->pos <= off + len);
+	return off + len - st->pos;
+}
+
+/*
+ * ringbuf_pipe_get: get the range to be processed by the given stage.
+ *
+ * => Returns the length of the range (zero if there is nothing to do)
+ *    and sets its offset.
+ * => Only the thread of the stage may call it.
+ */
+size_t
+ringbuf_pipe_get(ringbuf_pipe_t *p, unsigned i, size_t *offset)
+{
+	struct pipe_stage *st = &p->stage[i];
+	size_t len;
+
+	ASSERT(i < p->nstages);
+
+	if (i == 0) {
+		len = pipe_consume(p, st);
+	} else {
+		const uint64_t prev = atomic_load_explicit(
+		    &p->stage[i - 1].cursor, memory_order_acquire);
+
+		if (CURSOR_LAP(prev) != st->lap) {
+			/* The previous stage entered the next lap. */
+			st->lap = CURSOR_LAP(prev);
+			st->pos = 0;
+		}
+		len = CURSOR_OFF(prev) - st->pos;
+	}
+	st->len = len;
+	*offset = st->pos;
+	return len;
+}
+
+/*
+ * ringbuf_pipe_done: indicate that the given stage processed the given
+ * number of bytes from the start of its range, which must end at the
+ * record boundary.
+ */
+void
+ringbuf_pipe_done(ringbuf_pipe_t *p, unsigned i, size_t nbytes)
+{
+	struct pipe_stage *st = &p->stage[i];
+
+	ASSERT(i < p->nstages);
+	ASSERT(nbytes <= st->len);
+
+	st->pos += nbytes;
+	st->len -= nbytes;
+	atomic_store_explicit(&st->cursor, CURSOR(st->lap, st->pos),
+	    memory_order_release);
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_PIPE_H_
+#define _RINGBUF_PIPE_H_
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_pipe ringbuf_pipe_t;
+
+ringbuf_pipe_t *ringbuf_pipe_create(ringbuf_t *, unsigned);
+void		ringbuf_pipe_destroy(ringbuf_pipe_t *);
+
+size_t		ringbuf_pipe_get(ringbuf_pipe_t *, unsigned, size_t *);
+void		ringbuf_pipe_done(ringbuf_pipe_t *, unsigned, size_t);
+
+__END_DECLS
+
+#endif
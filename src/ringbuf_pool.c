@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Lock-free pool of the fixed-size blocks.
+ *
+ * The free blocks are kept on a stack (a singly linked list) with the
+ * links stored in a separate array, so that the block memory itself is
+ * never touched by the allocator.  The head is a 64-bit word containing
+ * the index of the top block and a generation counter, which is
+ * incremented on every update to prevent the ABA problem.
+ *
+ * The blocks are referenced using the indexes, therefore the pool can
+ * be placed in the shared memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_pool.h"
+#include "utils.h"
+
+#define	POOL_NONE		UINT32_MAX
+#define	POOL_IDX(head)		((uint32_t)(head))
+#define	POOL_HEAD(gen, idx)	(((uint64_t)(gen) << 32) | (idx))
+#define	POOL_GEN(head)		((uint32_t)((head) >> 32))
+
+struct ringbuf_pool {
+	volatile uint64_t	head;
+	uint8_t			_pad[CACHE_LINE_SIZE - sizeof(uint64_t)];
+
+	unsigned		nblocks;
+	size_t			blksize;
+	size_t			blocks_off;
+	volatile uint32_t	next[];
+};
+
+static size_t
+pool_blocks_off(unsigned nblocks)
+{
+	return roundup2(offsetof(ringbuf_pool_t, next[nblocks]),
+	    CACHE_LINE_SIZE);
+}
+
+/*
+ * ringbuf_pool_get_size: return the size of the pool object, including
+ * the blocks.
+ */
+size_t
+ringbuf_pool_get_size(unsigned nblocks, size_t blksize)
+{
+	return pool_blocks_off(nblocks) +
+	    (size_t)nblocks * roundup2(blksize, CACHE_LINE_SIZE);
+}
+
+/*
+ * ringbuf_pool_setup: initialise the pool of 'nblocks' blocks, each
+ * of 'blksize' bytes (rounded up to the cache line size).
+ */
+int
+ringbuf_pool_setup(ringbuf_pool_t *pool, unsigned nblocks, size_t blksize)
+{
+	if (nblocks == 0 || nblocks >= POOL_NONE || blksize == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(pool, 0, pool_blocks_off(nblocks));
+	pool->nblocks = nblocks;
+	pool->blksize = roundup2(blksize, CACHE_LINE_SIZE);
+	pool->blocks_off = pool_blocks_off(nblocks);
+
+	for (unsigned i = 0; i < nblocks; i++) {
+		pool->next[i] = (i + 1 < nblocks) ? i + 1 : POOL_NONE;
+	}
+	pool->head = POOL_HEAD(0, 0);
+	return 0;
+}
+
+size_t
+ringbuf_pool_blksize(const ringbuf_pool_t *pool)
+{
+	return pool->blksize;
+}
+
+/*
+ * ringbuf_pool_block: return the block with the given index.
+ */
+void *
+ringbuf_pool_block(ringbuf_pool_t *pool, uint32_t idx)
+{
+	ASSERT(idx < pool->nblocks);
+	return (uint8_t *)pool + pool->blocks_off + (size_t)idx * pool->blksize;
+}
+
+/*
+ * ringbuf_pool_index: return the index of the given block.
+ */
+uint32_t
+ringbuf_pool_index(ringbuf_pool_t *pool, const void *blk)
+{
+	const size_t off = (const uint8_t *)blk - (const uint8_t *)pool;
+
+	ASSERT(off >= pool->blocks_off);
+	ASSERT((off - pool->blocks_off) % pool->blksize == 0);
+	return (off - pool->blocks_off) / pool->blksize;
+}
+
+/*
+ * ringbuf_pool_alloc: allocate a block; returns NULL if exhausted.
+ */
+void *
+ringbuf_pool_alloc(ringbuf_pool_t *pool)
+{
+	uint64_t head, nhead;
+	uint32_t idx;
+
+	do {
+		/*
+		 * Note: the link of a block, which might be concurrently
+		 * allocated, can be stale; the CAS would fail in such case.
+		 */
+		head = atomic_load_explicit(&pool->head, memory_order_acquire);
+		if ((idx = POOL_IDX(head)) == POOL_NONE) {
+			return NULL;
+		}
+		nhead = POOL_HEAD(POOL_GEN(head) + 1,
+		    atomic_load_explicit(&pool->next[idx], memory_order_relaxed));
+	} while (!atomic_compare_exchange_weak(&pool->head, &head, nhead));
+
+	return ringbuf_pool_block(pool, idx);
+}
+
+/*
+ * ringbuf_pool_free: return the block to the pool.
+ */
+void
+ringbuf_pool_free(ringbuf_pool_t *pool, void *blk)
+{
+	const uint32_t idx = ringbuf_pool_index(pool, blk);
+	uint64_t head, nhead;
+
+	do {
+		head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+		atomic_store_explicit(&pool->next[idx], POOL_IDX(head),
+		    memory_order_relaxed);
+		nhead = POOL_HEAD(POOL_GEN(head) + 1, idx);
+	} while (!atomic_compare_exchange_weak(&pool->head, &head, nhead));
+}
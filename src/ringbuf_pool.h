@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_POOL_H_
+#define _RINGBUF_POOL_H_
+
+#include <inttypes.h>
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_pool ringbuf_pool_t;
+
+size_t		ringbuf_pool_get_size(unsigned, size_t);
+int		ringbuf_pool_setup(ringbuf_pool_t *, unsigned, size_t);
+size_t		ringbuf_pool_blksize(const ringbuf_pool_t *);
+
+void *		ringbuf_pool_alloc(ringbuf_pool_t *);
+void		ringbuf_pool_free(ringbuf_pool_t *, void *);
+
+uint32_t	ringbuf_pool_index(ringbuf_pool_t *, const void *);
+void *		ringbuf_pool_block(ringbuf_pool_t *, uint32_t);
+
+__END_DECLS
+
+#endif
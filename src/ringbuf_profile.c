@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Ring buffer usage profile and the sizing advisor.
+ *
+ * Recording
+ *
+ *	The producers acquire the space using ringbuf_profile_acquire(),
+ *	which counts only the failures (and the largest request), so the
+ *	fast path is not affected.  A monitoring thread (or the consumer)
+ *	periodically takes a sample: the outstanding bytes, i.e. acquired
+ *	but not yet released, and the failures since the previous sample.
+ *	The samples are aggregated into the time windows of the given
+ *	length; the statistics of the recent windows are kept.
+ *
+ * Bursts
+ *
+ *	A burst is a period during which the outstanding bytes exceed the
+ *	given threshold or the acquire calls fail.  Its duration is the
+ *	time between the first and the last sample of the period.
+ *
+ * Advisor
+ *
+ *	The demand at a sample is estimated as the outstanding bytes plus
+ *	the largest failed request since the previous sample (i.e. what
+ *	the ring would hold if it was large enough).  The failed bytes are
+ *	not summed: a producer spinning on a full ring fails the same
+ *	record many times, which would count it once per retry.
+ *	The demand is recorded in a log-linear histogram (eight sub-buckets
+ *	per power of two, i.e. the relative error is within 12.5%).  For
+ *	the target drop rate, the advisor takes the demand quantile, so
+ *	that the fraction of the samples exceeding it is within the target,
+ *	and adds the headroom for the largest record: a producer cannot
+ *	catch up with the consumer and the space at the end is lost on the
+ *	wrap-around.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_profile.h"
+#include "utils.h"
+
+#define	PROFILE_SUB		8
+#define	PROFILE_SUB_SHIFT	3
+#define	PROFILE_NBUCKETS	(PROFILE_SUB * (64 - 2))
+
+struct ringbuf_profile {
+	/* Updated by the producers. */
+	volatile uint64_t	nfail;
+	volatile uint64_t	nfailbytes;
+	volatile uint64_t	failmax;	/* largest failed, per sample */
+	volatile uint64_t	maxlen;
+	uint8_t			_pad[CACHE_LINE_SIZE - 4 * sizeof(uint64_t)];
+
+	/* Updated by the sampling thread. */
+	uint64_t		window;
+	size_t			threshold;
+	uint64_t		last_nfail;
+	uint64_t		last_nfailbytes;
+	uint64_t		burst_start;
+	bool			in_burst;
+
+	ringbuf_profile_stats_t	cur;
+	unsigned		nwindows;
+	ringbuf_profile_stats_t	windows[RINGBUF_PROFILE_NWINDOWS];
+
+	uint64_t		nsamples;
+	uint64_t		hist[PROFILE_NBUCKETS];
+};
+
+static unsigned
+profile_bucket(uint64_t val)
+{
+	unsigned e;
+
+	if (val < 2 * PROFILE_SUB) {
+		return val;
+	}
+	e = 63 - __builtin_clzll(val);
+	return PROFILE_SUB * (e - PROFILE_SUB_SHIFT + 1) +
+	    ((val >> (e - PROFILE_SUB_SHIFT)) & (PROFILE_SUB - 1));
+}
+
+static uint64_t
+profile_bucket_max(unsigned i)
+{
+	unsigned e, shift;
+
+	if (i < 2 * PROFILE_SUB) {
+		return i;
+	}
+	e = i / PROFILE_SUB + PROFILE_SUB_SHIFT - 1;
+	shift = e - PROFILE_SUB_SHIFT;
+	return (((uint64_t)(PROFILE_SUB + i % PROFILE_SUB) + 1) << shift) - 1;
+}
+
+/*
+ * ringbuf_profile_get_size: return the size of the profile object.
+ */
+size_t
+ringbuf_profile_get_size(void)
+{
+	return sizeof(ringbuf_profile_t);
+}
+
+/*
+ * ringbuf_profile_setup: initialise the profile with the given window
+ * length (in the time units of the samples) and the burst threshold
+ * (in bytes).
+ */
+int
+ringbuf_profile_setup(ringbuf_profile_t *p, uint64_t window, size_t threshold)
+{
+	if (window == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(p, 0, sizeof(ringbuf_profile_t));
+	p->window = window;
+	p->threshold = threshold;
+	return 0;
+}
+
+static void
+profile_max(volatile uint64_t *ptr, uint64_t val)
+{
+	uint64_t cur;
+
+	/* Racy, but the largest value eventually sticks. */
+	while ((cur = *ptr) < val) {
+		if (atomic_compare_exchange_weak(ptr, &cur, val))
+			break;
+	}
+}
+
+/*
+ * ringbuf_profile_acquire: ringbuf_acquire() recording the failures.
+ */
+ssize_t
+ringbuf_profile_acquire(ringbuf_profile_t *p, ringbuf_t *rbuf,
+    ringbuf_worker_t *w, size_t len)
+{
+	ssize_t off;
+
+	if (__predict_false(len > p->maxlen)) {
+		profile_max(&p->maxlen, len);
+	}
+	if ((off = ringbuf_acquire(rbuf, w, len)) == -1) {
+		atomic_fetch_add_explicit(&p->nfail, 1, memory_order_relaxed);
+		atomic_fetch_add_explicit(&p->nfailbytes, len,
+		    memory_order_relaxed);
+		if (len > p->failmax) {
+			profile_max(&p->failmax, len);
+		}
+	}
+	return off;
+}
+
+static void
+profile_close_window(ringbuf_profile_t *p, uint64_t now)
+{
+	const unsigned i = p->nwindows++ % RINGBUF_PROFILE_NWINDOWS;
+
+	p->windows[i] = p->cur;
+	memset(&p->cur, 0, sizeof(ringbuf_profile_stats_t));
+	p->cur.start = now;
+}
+
+/*
+ * ringbuf_profile_sample: take a sample of the ring buffer usage at the
+ * given time.  Only one thread may take the samples.
+ */
+void
+ringbuf_profile_sample(ringbuf_profile_t *p, ringbuf_t *rbuf, uint64_t now)
+{
+	const uint64_t usage = ringbuf_get_usage(rbuf);
+	const uint64_t nfail = atomic_load_explicit(&p->nfail,
+	    memory_order_relaxed);
+	const uint64_t nfailbytes = atomic_load_explicit(&p->nfailbytes,
+	    memory_order_relaxed);
+	const uint64_t dfail = nfail - p->last_nfail;
+	const uint64_t dbytes = nfailbytes - p->last_nfailbytes;
+	ringbuf_profile_stats_t *cur = &p->cur;
+	uint64_t failmax;
+
+	/* Take the largest failed request and reset it. */
+	while ((failmax = p->failmax) != 0 &&
+	    !atomic_compare_exchange_weak(&p->failmax, &failmax, 0))
+		;
+	p->last_nfail = nfail;
+	p->last_nfailbytes = nfailbytes;
+
+	if (cur->nsamples == 0) {
+		cur->start = now;
+	} else if (now - cur->start >= p->window) {
+		profile_close_window(p, now);
+	}
+	cur->nsamples++;
+	cur->peak = MAX(cur->peak, usage);
+	cur->nfail += dfail;
+	cur->nfailbytes += dbytes;
+
+	if (usage > p->threshold || dfail) {
+		if (!p->in_burst) {
+			p->in_burst = true;
+			p->burst_start = now;
+			cur->nbursts++;
+		}
+		cur->burst_max = MAX(cur->burst_max, now - p->burst_start);
+	} else {
+		p->in_burst = false;
+	}
+
+	p->hist[profile_bucket(usage + failmax)]++;
+	p->nsamples++;
+}
+
+/*
+ * ringbuf_profile_windows: copy the statistics of up to 'n' most recent
+ * complete windows, the newest first.  Returns the number copied.
+ */
+unsigned
+ringbuf_profile_windows(const ringbuf_profile_t *p,
+    ringbuf_profile_stats_t *stats, unsigned n)
+{
+	const unsigned avail = MIN(p->nwindows, RINGBUF_PROFILE_NWINDOWS);
+
+	n = MIN(n, avail);
+	for (unsigned i = 0; i < n; i++) {
+		const unsigned idx = (p->nwindows - 1 - i) %
+		    RINGBUF_PROFILE_NWINDOWS;
+		stats[i] = p->windows[idx];
+	}
+	return n;
+}
+
+/*
+ * ringbuf_profile_advise: recommend the smallest ring buffer size which
+ * would keep the fraction of the samples with dropped data within the
+ * given target, for the workload observed so far.
+ *
+ * => Returns zero if there are no samples.
+ */
+size_t
+ringbuf_profile_advise(const ringbuf_profile_t *p, double droprate)
+{
+	const uint64_t allowed = (uint64_t)(droprate * p->nsamples);
+	uint64_t demand = 0, count = 0;
+
+	if (p->nsamples == 0) {
+		return 0;
+	}
+
+	/*
+	 * Find the highest demand which has to be accommodated, i.e. the
+	 * samples in the higher buckets are within the allowed drops.
+	 */
+	for (unsigned i = PROFILE_NBUCKETS; i-- > 0;) {
+		if (count + p->hist[i] > allowed) {
+			demand = profile_bucket_max(i);
+			break;
+		}
+		count += p->hist[i];
+	}
+	return roundup2(demand + p->maxlen + 1, CACHE_LINE_SIZE);
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_PROFILE_H_
+#define _RINGBUF_PROFILE_H_
+
+#include <inttypes.h>
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_profile ringbuf_profile_t;
+
+typedef struct {
+	uint64_t	start;		/* start time of the window */
+	uint64_t	nsamples;
+	uint64_t	peak;		/* peak outstanding bytes */
+	uint64_t	nfail;		/* failed acquire calls */
+	uint64_t	nfailbytes;	/* .. and the bytes requested */
+	uint64_t	nbursts;
+	uint64_t	burst_max;	/* longest burst duration */
+} ringbuf_profile_stats_t;
+
+/* Number of the past windows kept. */
+#define	RINGBUF_PROFILE_NWINDOWS	64
+
+size_t		ringbuf_profile_get_size(void);
+int		ringbuf_profile_setup(ringbuf_profile_t *, uint64_t, size_t);
+
+ssize_t		ringbuf_profile_acquire(ringbuf_profile_t *, ringbuf_t *,
+		    ringbuf_worker_t *, size_t);
+void		ringbuf_profile_sample(ringbuf_profile_t *, ringbuf_t *,
+		    uint64_t);
+
+unsigned	ringbuf_profile_windows(const ringbuf_profile_t *,
+		    ringbuf_profile_stats_t *, unsigned);
+size_t		ringbuf_profile_advise(const ringbuf_profile_t *, double);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Replication of a ring buffer over a stream socket.
+ *
+ * The source side is the consumer of the source ring of framed records:
+ * it ships the consumed ranges, as they are, in batches of whole records
+ * up to 'maxbatch' bytes, each preceded by a small header.  The
+ * destination side receives the whole batch into a staging buffer, then
+ * acquires the space for it in the destination ring, copies it and
+ * produces it; then it acknowledges the cumulative number of bytes
+ * received.  The reservation is not held across the network I/O, which
+ * may block, since it would block the consumer and other producers of
+ * the destination ring.  The source releases the data only once it is
+ * acknowledged, i.e. the data is not lost if the destination fails.
+ * Since the batches consist of whole records, the destination consumer
+ * sees the same records.  The cost is a write, a read and a copy per
+ * batch rather than per record.
+ *
+ * Only the self-contained records are shipped: the out-of-line payloads
+ * (pool offsets), the transactions (IDs into the source table, possibly
+ * still open) and the keyed records (which may be updated in place after
+ * shipping) are not supported; such records are rejected.
+ *
+ * A failed (or short) transfer leaves the stream position undefined,
+ * therefore the endpoint is then broken: the error is sticky and all
+ * further calls fail with it.
+ *
+ * The source ships ahead of the acknowledgements: the shipped, but not
+ * yet released range is skipped when consuming again.  The consumer
+ * wrap-around happens only once the whole range up to the 'end' offset
+ * is released, therefore the unacknowledged batches are always within
+ * the same lap; it is detected as the range not starting at the offset
+ * released up to.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_repl.h"
+#include "ringbuf_frame.h"
+#include "utils.h"
+
+#define	REPL_MAGIC	0x52504c31	/* "RPL1" */
+
+typedef struct {
+	uint32_t	len;
+	uint32_t	magic;
+} repl_hdr_t;
+
+struct ringbuf_repl {
+	int		fd;
+	size_t		maxbatch;
+	int		error;		/* sticky error; zero if none */
+
+	/* Source side. */
+	size_t		released;	/* offset released up to */
+	size_t		shipped;	/* .. and shipped up to */
+	uint64_t	nshipped;	/* total bytes shipped */
+	uint64_t	nacked;		/* .. and acknowledged */
+	uint8_t		ackbuf[sizeof(uint64_t)];
+	size_t		acklen;
+
+	/* Destination side. */
+	bool		pending;	/* batch staged, no space yet */
+	repl_hdr_t	hdr;
+	uint64_t	nreceived;
+	uint8_t *	stage;		/* staging buffer of 'maxbatch' */
+};
+
+/*
+ * ringbuf_repl_create: construct the replication endpoint on the
+ * connected stream socket; 'maxbatch' is the maximum batch size, which
+ * must be less than the size of the destination ring.
+ */
+ringbuf_repl_t *
+ringbuf_repl_create(int fd, size_t maxbatch)
+{
+	ringbuf_repl_t *r;
+
+	if (maxbatch == 0 || maxbatch > UINT32_MAX) {
+		return NULL;
+	}
+	if ((r = calloc(1, sizeof(ringbuf_repl_t))) == NULL) {
+		return NULL;
+	}
+	if ((r->stage = malloc(maxbatch)) == NULL) {
+		free(r);
+		return NULL;
+	}
+	r->fd = fd;
+	r->maxbatch = maxbatch;
+	return r;
+}
+
+void
+ringbuf_repl_destroy(ringbuf_repl_t *r)
+{
+	free(r->stage);
+	free(r);
+}
+
+/*
+ * repl_broken: mark the endpoint broken with the current errno.
+ */
+static ssize_t
+repl_broken(ringbuf_repl_t *r)
+{
+	r->error = errno;
+	return -1;
+}
+
+/*
+ * repl_sendv: write the whole I/O vector, handling the short writes.
+ */
+static int
+repl_sendv(int fd, struct iovec *iov, int iovcnt)
+{
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	while (iovcnt) {
+		ssize_t ret;
+
+		msg.msg_iov = iov;
+		msg.msg_iovlen = iovcnt;
+		if ((ret = sendmsg(fd, &msg, MSG_NOSIGNAL)) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		while (iovcnt && (size_t)ret >= iov->iov_len) {
+			ret -= iov->iov_len;
+			iov++, iovcnt--;
+		}
+		if (iovcnt) {
+			iov->iov_base = (uint8_t *)iov->iov_base + ret;
+			iov->iov_len -= ret;
+		}
+	}
+	return 0;
+}
+
+/*
+ * repl_recvall: read exactly the given length (blocking).  Returns 0 on
+ * success and -1 on failure; the end of stream is ECONNRESET.
+ */
+static int
+repl_recvall(int fd, void *buf, size_t len)
+{
+	uint8_t *p = buf;
+
+	while (len) {
+		ssize_t ret;
+
+		if ((ret = recv(fd, p, len, MSG_WAITALL)) <= 0) {
+			if (ret == -1 && errno == EINTR) {
+				continue;
+			}
+			if (ret == 0) {
+				errno = ECONNRESET;
+			}
+			return -1;
+		}
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+/*
+ * ringbuf_repl_ack: process the acknowledgements and release the data.
+ * Only the source consumer.
+ *
+ * => The 'flags' are passed to recv(2), e.g. MSG_DONTWAIT; returns zero
+ *    immediately if there is no data in flight.
+ * => Returns the number of bytes released or -1 on failure.
+ */
+ssize_t
+ringbuf_repl_ack(ringbuf_repl_t *r, ringbuf_t *rbuf, int flags)
+{
+	size_t nbytes = 0;
+
+	if (r->error) {
+		errno = r->error;
+		return -1;
+	}
+	while (r->nacked < r->nshipped) {
+		uint64_t acked;
+		ssize_t ret;
+
+		ret = recv(r->fd, r->ackbuf + r->acklen,
+		    sizeof(r->ackbuf) - r->acklen, flags);
+		if (ret <= 0) {
+			if (ret == -1 && errno == EINTR) {
+				continue;
+			}
+			if (ret == -1 && (errno == EAGAIN ||
+			    errno == EWOULDBLOCK)) {
+				break;
+			}
+			if (ret == 0) {
+				errno = ECONNRESET;
+			}
+			return repl_broken(r);
+		}
+		if ((r->acklen += ret) < sizeof(r->ackbuf)) {
+			continue;
+		}
+		r->acklen = 0;
+
+		memcpy(&acked, r->ackbuf, sizeof(acked));
+		if (acked <= r->nacked || acked > r->nshipped) {
+			errno = EPROTO;
+			return repl_broken(r);
+		}
+		ringbuf_release(rbuf, acked - r->nacked);
+		r->released += acked - r->nacked;
+		nbytes += acked - r->nacked;
+		r->nacked = acked;
+
+		/* Do not block once something is released. */
+		flags |= MSG_DONTWAIT;
+	}
+	return nbytes;
+}
+
+/* The records which are not self-contained (see above). */
+#define	REPL_UNSUPP	\
+    (RINGBUF_FRAME_BLOB | RINGBUF_FRAME_TXN | RINGBUF_FRAME_KEY)
+
+/*
+ * repl_batch: return the length of the whole records, starting at the
+ * given offset, fitting the batch; stops at an unsupported record.
+ * Returns -1 if the first record cannot be shipped.
+ */
+static ssize_t
+repl_batch(const uint8_t *buf, size_t off, size_t len, size_t maxbatch)
+{
+	size_t blen = 0;
+
+	while (blen < len) {
+		const ringbuf_frame_t *f = (const void *)(buf + off + blen);
+		const size_t rlen = roundup2(ringbuf_frame_hdrlen(f) + f->len,
+		    RINGBUF_FRAME_ALIGN);
+
+		if (f->flags & REPL_UNSUPP) {
+			if (blen == 0) {
+				errno = ENOTSUP;
+				return -1;
+			}
+			break;
+		}
+		if (blen + rlen > maxbatch) {
+			if (blen == 0) {
+				errno = EMSGSIZE;
+				return -1;
+			}
+			break;
+		}
+		blen += rlen;
+	}
+	ASSERT(blen <= len);
+	return blen;
+}
+
+/*
+ * ringbuf_repl_send: ship the next batch of the consumed data, which
+ * was not yet shipped.  Only the source consumer.
+ *
+ * => The 'buf' is the data space of the source ring.
+ * => Returns the number of bytes shipped (zero if none) or -1 on failure;
+ *    errno is set to EMSGSIZE if a record does not fit the batch or to
+ *    ENOTSUP if it has an out-of-line payload, a transaction ID or a key
+ *    (the endpoint is not broken in these cases, but the record cannot
+ *    be shipped).
+ */
+ssize_t
+ringbuf_repl_send(ringbuf_repl_t *r, ringbuf_t *rbuf, const void *buf)
+{
+	struct iovec iov[2];
+	repl_hdr_t hdr;
+	size_t off, len;
+	ssize_t blen;
+
+	if (r->error) {
+		errno = r->error;
+		return -1;
+	}
+
+	/*
+	 * Process the pending acknowledgements first, so that neither
+	 * side blocks while the other is waiting for it.
+	 */
+	if (ringbuf_repl_ack(r, rbuf, MSG_DONTWAIT) == -1) {
+		return -1;
+	}
+	if ((len = ringbuf_consume(rbuf, &off)) == 0) {
+		return 0;
+	}
+	if (off != r->released) {
+		/* The consumer wrapped around. */
+		ASSERT(off == 0 && r->nacked == r->nshipped);
+		r->released = r->shipped = 0;
+	}
+	ASSERT(r->shipped >= off && r->shipped <= off + len);
+	if ((len = off + len - r->shipped) == 0) {
+		return 0;
+	}
+	if ((blen = repl_batch(buf, r->shipped, len, r->maxbatch)) == -1) {
+		return -1;
+	}
+	len = blen;
+
+	hdr.len = len;
+	hdr.magic = REPL_MAGIC;
+	iov[0].iov_base = &hdr;
+	iov[0].iov_len = sizeof(hdr);
+	iov[1].iov_base = (uint8_t *)(uintptr_t)buf + r->shipped;
+	iov[1].iov_len = len;
+	if (repl_sendv(r->fd, iov, 2) == -1) {
+		return repl_broken(r);
+	}
+	r->shipped += len;
+	r->nshipped += len;
+	return len;
+}
+
+/*
+ * ringbuf_repl_recv: receive a batch into the destination ring, produce
+ * it and acknowledge.  Blocks until a batch arrives.
+ *
+ * => The 'buf' is the data space of the destination ring.
+ * => Returns the number of bytes replicated or -1 on failure, in which
+ *    case errno is set to: ENOBUFS if the destination ring does not have
+ *    the space (the batch stays staged and the call can be retried),
+ *    EINVAL if 'maxbatch' is not less than the destination ring size,
+ *    ECONNRESET if the source has closed the connection or EPROTO if
+ *    the stream is corrupt.  Other than ENOBUFS and EINVAL, the endpoint
+ *    is then broken.
+ */
+ssize_t
+ringbuf_repl_recv(ringbuf_repl_t *r, ringbuf_t *rbuf, ringbuf_worker_t *w,
+    void *buf)
+{
+	struct iovec iov;
+	uint64_t acked;
+	ssize_t off;
+
+	if (r->error) {
+		errno = r->error;
+		return -1;
+	}
+	if (r->maxbatch >= ringbuf_get_space(rbuf)) {
+		/* A full batch could never be acquired. */
+		errno = EINVAL;
+		return -1;
+	}
+	if (!r->pending) {
+		if (repl_recvall(r->fd, &r->hdr, sizeof(r->hdr)) == -1) {
+			return repl_broken(r);
+		}
+		if (r->hdr.magic != REPL_MAGIC || r->hdr.len == 0 ||
+		    r->hdr.len > r->maxbatch ||
+		    r->hdr.len % RINGBUF_FRAME_ALIGN != 0) {
+			errno = EPROTO;
+			return repl_broken(r);
+		}
+		if (repl_recvall(r->fd, r->stage, r->hdr.len) == -1) {
+			return repl_broken(r);
+		}
+		r->pending = true;
+	}
+
+	/* Only now acquire: the reservation is not held across the I/O. */
+	if ((off = ringbuf_acquire(rbuf, w, r->hdr.len)) == -1) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	r->pending = false;
+	memcpy((uint8_t *)buf + off, r->stage, r->hdr.len);
+	ringbuf_produce(rbuf, w);
+	r->nreceived += r->hdr.len;
+
+	acked = r->nreceived;
+	iov.iov_base = &acked;
+	iov.iov_len = sizeof(acked);
+	if (repl_sendv(r->fd, &iov, 1) == -1) {
+		return repl_broken(r);
+	}
+	return r->hdr.len;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_REPL_H_
+#define _RINGBUF_REPL_H_
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_repl ringbuf_repl_t;
+
+ringbuf_repl_t *ringbuf_repl_create(int, size_t);
+void		ringbuf_repl_destroy(ringbuf_repl_t *);
+
+ssize_t		ringbuf_repl_send(ringbuf_repl_t *, ringbuf_t *, const void *);
+ssize_t		ringbuf_repl_ack(ringbuf_repl_t *, ringbuf_t *, int);
+ssize_t		ringbuf_repl_recv(ringbuf_repl_t *, ringbuf_t *,
+		    ringbuf_worker_t *, void *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Retention window and sequence-based random access.
+ *
+ * The release only marks the data as consumed: it remains in the data
+ * space until the producers need the space and overwrite it.  Since the
+ * space is reused in the FIFO order, the data space retains the most
+ * recent records, i.e. the ring buffer of size S with at most U bytes in
+ * use keeps at least the last S - U bytes after the consumption.  This
+ * lets a late-joining reader (e.g. a debug tap or a replica catching up)
+ * to start from the history.
+ *
+ * The consumer assigns the sequence numbers to the records, in the order
+ * of consumption, and stores their positions in the index: a table of
+ * the power-of-two size, indexed by the sequence number, so the seek is
+ * O(1).  The position is the lap number (the wrap-around counter) and
+ * the offset of the record.
+ *
+ * Readers
+ *
+ *	Any thread may read the records concurrently with the producers
+ *	and the consumer.  The index entry is read as a seqlock, tagged
+ *	with the sequence number.  The record is copied out and then
+ *	validated: it is intact if the frontier of the producers (see
+ *	ringbuf_get_frontier()) has not passed its position.  The header
+ *	is validated before using its length.
+ *
+ * Note: the out-of-line payloads are freed on release and the durable
+ * release clears the headers, therefore such records cannot be read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_retain.h"
+#include "utils.h"
+
+#define	POS_LAP(p)	((uint32_t)((p) >> 32))
+#define	POS_OFF(p)	((size_t)((p) & 0xffffffffUL))
+#define	LAP_MASK	(0x7fffffffU)
+
+struct ringbuf_retain {
+	ringbuf_t *		rbuf;
+	uint8_t *		buf;
+	unsigned		mask;
+	volatile uint64_t	next;	/* next sequence number */
+	struct retain_ent {
+		volatile uint64_t tag;	/* sequence number + 1; zero if none */
+		volatile uint64_t pos;
+	} index[];
+};
+
+/*
+ * ringbuf_retain_create: construct the retention index of the given
+ * number of entries (must be a power of two) for the ring buffer and
+ * its data space.
+ */
+ringbuf_retain_t *
+ringbuf_retain_create(ringbuf_t *rbuf, void *buf, unsigned nindex)
+{
+	ringbuf_retain_t *r;
+
+	if (nindex == 0 || (nindex & (nindex - 1)) != 0) {
+		return NULL;
+	}
+	r = calloc(1, offsetof(ringbuf_retain_t, index[nindex]));
+	if (r == NULL) {
+		return NULL;
+	}
+	r->rbuf = rbuf;
+	r->buf = buf;
+	r->mask = nindex - 1;
+	return r;
+}
+
+void
+ringbuf_retain_destroy(ringbuf_retain_t *r)
+{
+	free(r);
+}
+
+/*
+ * retain_intact: return true if the space at the given position has not
+ * been overwritten, i.e. the producers have not acquired it in the next
+ * lap (or beyond).
+ */
+static bool
+retain_intact(ringbuf_retain_t *r, uint64_t pos)
+{
+	const uint64_t frontier = ringbuf_get_frontier(r->rbuf);
+	const uint32_t laps = (POS_LAP(frontier) - POS_LAP(pos)) & LAP_MASK;
+
+	return laps == 0 || (laps == 1 && POS_OFF(frontier) <= POS_OFF(pos));
+}
+
+/*
+ * ringbuf_retain_add: index the consumed record and return its sequence
+ * number.  Only the consumer, before the record is released.
+ */
+uint64_t
+ringbuf_retain_add(ringbuf_retain_t *r, const ringbuf_frame_t *f)
+{
+	const size_t off = (size_t)((const uint8_t *)f - r->buf);
+	const uint64_t frontier = ringbuf_get_frontier(r->rbuf);
+	const uint64_t seq = r->next;
+	struct retain_ent *ent = &r->index[seq & r->mask];
+	uint32_t lap = POS_LAP(frontier);
+
+	/*
+	 * The record is not released, therefore the frontier is either
+	 * past it in the same lap or behind it in the next lap.
+	 */
+	if (POS_OFF(frontier) <= off) {
+		lap = (lap - 1) & LAP_MASK;
+	}
+
+	atomic_store_explicit(&ent->tag, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&ent->pos, ((uint64_t)lap << 32) | off,
+	    memory_order_relaxed);
+	atomic_store_explicit(&ent->tag, seq + 1, memory_order_release);
+	atomic_store_explicit(&r->next, seq + 1, memory_order_release);
+	return seq;
+}
+
+/*
+ * ringbuf_retain_next: return the sequence number of the next record
+ * to be indexed.  Any thread may call it.
+ */
+uint64_t
+ringbuf_retain_next(ringbuf_retain_t *r)
+{
+	return atomic_load_explicit(&r->next, memory_order_acquire);
+}
+
+/*
+ * retain_lookup: get the position of the record from the index.
+ */
+static bool
+retain_lookup(ringbuf_retain_t *r, uint64_t seq, uint64_t *pos)
+{
+	struct retain_ent *ent = &r->index[seq & r->mask];
+
+	if (atomic_load_explicit(&ent->tag, memory_order_acquire) != seq + 1) {
+		return false;
+	}
+	*pos = atomic_load_explicit(&ent->pos, memory_order_relaxed);
+	atomic_thread_fence(memory_order_acquire);
+	return atomic_load_explicit(&ent->tag, memory_order_relaxed) == seq + 1;
+}
+
+/*
+ * ringbuf_retain_oldest: return the sequence number of the oldest record
+ * which is still retained (or the next one, if there are none).  Any
+ * thread may call it.  The value is approximate, as the record may be
+ * overwritten at any time.
+ */
+uint64_t
+ringbuf_retain_oldest(ringbuf_retain_t *r)
+{
+	const uint64_t next = ringbuf_retain_next(r);
+	const uint64_t nindex = (uint64_t)r->mask + 1;
+	uint64_t lo = next > nindex ? next - nindex : 0, hi = next;
+
+	/*
+	 * The records are overwritten in the order of the sequence
+	 * numbers: binary search for the first one which is intact.
+	 */
+	while (lo < hi) {
+		const uint64_t mid = lo + (hi - lo) / 2;
+		uint64_t pos;
+
+		if (retain_lookup(r, mid, &pos) && retain_intact(r, pos)) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return lo;
+}
+
+/*
+ * ringbuf_retain_read: copy out the payload of the record with the given
+ * sequence number.  Any thread may call it.
+ *
+ * => Returns the length of the payload on success.
+ * => On failure, returns -1 and sets errno: ENOENT if the record is not
+ *    in the index, ESTALE if it was overwritten, EMSGSIZE if the buffer
+ *    is too small and ENOTSUP if the payload is out-of-line.
+ */
+ssize_t
+ringbuf_retain_read(ringbuf_retain_t *r, uint64_t seq, void *dst, size_t len)
+{
+	ringbuf_frame_t hdr;
+	const uint8_t *rec;
+	uint64_t pos;
+
+	if (!retain_lookup(r, seq, &pos)) {
+		errno = ENOENT;
+		return -1;
+	}
+	rec = r->buf + POS_OFF(pos);
+
+	/*
+	 * Copy and validate the header first, so that its length can
+	 * be trusted; then copy and validate the payload.
+	 */
+	memcpy(&hdr, rec, sizeof(ringbuf_frame_t));
+	atomic_thread_fence(memory_order_acquire);
+	if (!retain_intact(r, pos)) {
+		errno = ESTALE;
+		return -1;
+	}
+	if (hdr.flags & RINGBUF_FRAME_BLOB) {
+		errno = ENOTSUP;
+		return -1;
+	}
+	if (hdr.len > len) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+	memcpy(dst, rec + ringbuf_frame_hdrlen(&hdr), hdr.len);
+	atomic_thread_fence(memory_order_acquire);
+	if (!retain_intact(r, pos)) {
+		errno = ESTALE;
+		return -1;
+	}
+	return hdr.len;
+}
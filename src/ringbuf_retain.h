@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_RETAIN_H_
+#define _RINGBUF_RETAIN_H_
+
+#include <inttypes.h>
+
+#include "ringbuf.h"
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_retain ringbuf_retain_t;
+
+ringbuf_retain_t *ringbuf_retain_create(ringbuf_t *, void *, unsigned);
+void		ringbuf_retain_destroy(ringbuf_retain_t *);
+
+uint64_t	ringbuf_retain_add(ringbuf_retain_t *, const ringbuf_frame_t *);
+uint64_t	ringbuf_retain_next(ringbuf_retain_t *);
+uint64_t	ringbuf_retain_oldest(ringbuf_retain_t *);
+ssize_t		ringbuf_retain_read(ringbuf_retain_t *, uint64_t,
+		    void *, size_t);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Budgeted consume loop for a consumer thread serving multiple rings.
+ *
+ * A round visits every ring and processes its framed records, up to
+ * the budget (records and, optionally, payload bytes); the rest is left
+ * for the next round, so that a busy ring cannot starve the others and
+ * the thread returns to the caller regularly for its other work.
+ *
+ * Adaptive mode (in the spirit of NAPI interrupt mitigation)
+ *
+ *	In the polling mode, the idle rounds spin.  After a number of
+ *	consecutive idle rounds, the scheduler switches to the blocking
+ *	mode, where an idle round puts the thread to sleep until one of
+ *	the producers calls ringbuf_sched_notify().  The arrival rate is
+ *	tracked as an exponentially weighted moving average of the records
+ *	per round; once it reaches the threshold, the scheduler switches
+ *	back to the polling mode.
+ *
+ * Wake-up
+ *
+ *	The same protocol as in the request/response channel: the consumer
+ *	sets the 'sleeping' flag, issues a full memory barrier and checks
+ *	the rings once more; the producer issues a full memory barrier
+ *	after producing and checks the flag.  Therefore, the producers make
+ *	the system call only when the consumer is (about to be) sleeping.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "ringbuf_sched.h"
+#include "utils.h"
+
+/* The EWMA weight of the new value is 1/8. */
+#define	SCHED_EWMA_SHIFT	3
+
+struct ringbuf_sched {
+	/* Wake-up words, shared with the producers. */
+	volatile uint32_t	seq;
+	volatile uint32_t	sleeping;
+	uint8_t			_pad[CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+
+	ringbuf_sched_params_t	params;
+	ringbuf_sched_stats_t	stats;
+	unsigned		idle;
+	unsigned		rate;	/* scaled by 2^SCHED_EWMA_SHIFT */
+
+	unsigned		nrings;
+	struct sched_ring {
+		ringbuf_frame_iter_t it;
+		bool		active;
+	} ring[];
+};
+
+/*
+ * ringbuf_sched_create: construct the scheduler for the given number
+ * of rings; they must be added using ringbuf_sched_add().
+ */
+ringbuf_sched_t *
+ringbuf_sched_create(unsigned nrings, const ringbuf_sched_params_t *params)
+{
+	ringbuf_sched_t *s;
+
+	if (params->budget == 0) {
+		return NULL;
+	}
+	s = calloc(1, offsetof(ringbuf_sched_t, ring[nrings]));
+	if (s == NULL) {
+		return NULL;
+	}
+	s->params = *params;
+	s->stats.mode = RINGBUF_SCHED_POLL;
+	s->nrings = nrings;
+	return s;
+}
+
+void
+ringbuf_sched_destroy(ringbuf_sched_t *s)
+{
+	free(s);
+}
+
+/*
+ * ringbuf_sched_add: set the ring buffer and its data space for the
+ * given index.  Returns the iterator, e.g. to set the pool.
+ */
+ringbuf_frame_iter_t *
+ringbuf_sched_add(ringbuf_sched_t *s, unsigned i, ringbuf_t *rbuf, void *buf)
+{
+	struct sched_ring *r = &s->ring[i];
+
+	ASSERT(i < s->nrings);
+	ringbuf_frame_iter_init(&r->it, rbuf, buf);
+	r->active = true;
+	return &r->it;
+}
+
+/*
+ * sched_drain: process the records of the ring, up to the budget.
+ */
+static unsigned
+sched_drain(ringbuf_sched_t *s, unsigned i,
+    ringbuf_sched_handler_t handler, void *arg)
+{
+	ringbuf_frame_iter_t *it = &s->ring[i].it;
+	const size_t budget_bytes = s->params.budget_bytes;
+	unsigned n = 0;
+	size_t nbytes = 0;
+
+	if (ringbuf_frame_consume(it, 0) == 0) {
+		return 0;
+	}
+	while (n < s->params.budget &&
+	    (budget_bytes == 0 || nbytes < budget_bytes)) {
+		ringbuf_frame_t *f;
+
+		if ((f = ringbuf_frame_next(it)) == NULL) {
+			break;
+		}
+		handler(arg, i, f);
+		nbytes += f->len;
+		n++;
+	}
+	if (it->pos < it->len) {
+		s->stats.nbudget++;
+	}
+	ringbuf_frame_release(it);
+	return n;
+}
+
+/*
+ * sched_pending: check whether any of the rings has a record to deliver.
+ * The records which would be skipped (e.g. padding or superseded) do not
+ * count and are released; neither does a record of an open transaction.
+ */
+static bool
+sched_pending(ringbuf_sched_t *s)
+{
+	for (unsigned i = 0; i < s->nrings; i++) {
+		struct sched_ring *r = &s->ring[i];
+		bool ready;
+
+		if (!r->active || ringbuf_frame_consume(&r->it, 0) == 0) {
+			continue;
+		}
+		ready = ringbuf_frame_peek(&r->it) != NULL;
+		ringbuf_frame_release(&r->it);
+		if (ready) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void
+sched_sleep(ringbuf_sched_t *s)
+{
+	const uint32_t seq = atomic_load_explicit(&s->seq,
+	    memory_order_relaxed);
+
+	atomic_store_explicit(&s->sleeping, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (!sched_pending(s)) {
+		s->stats.nsleeps++;
+		futex_wait(&s->seq, seq);
+	}
+	atomic_store_explicit(&s->sleeping, 0, memory_order_relaxed);
+}
+
+/*
+ * ringbuf_sched_poll: run a round over the rings, invoking the handler
+ * for each record.  If no records were processed, then either spin or
+ * block, depending on the mode.
+ *
+ * => Returns the number of records processed.
+ */
+unsigned
+ringbuf_sched_poll(ringbuf_sched_t *s, ringbuf_sched_handler_t handler,
+    void *arg)
+{
+	ringbuf_sched_stats_t *stats = &s->stats;
+	unsigned n = 0;
+
+	for (unsigned i = 0; i < s->nrings; i++) {
+		if (s->ring[i].active) {
+			n += sched_drain(s, i, handler, arg);
+		}
+	}
+	stats->nrounds++;
+	stats->nrecords += n;
+	s->rate = s->rate - (s->rate >> SCHED_EWMA_SHIFT) + n;
+
+	if (n) {
+		s->idle = 0;
+		if (stats->mode == RINGBUF_SCHED_INTR &&
+		    (s->rate >> SCHED_EWMA_SHIFT) >= s->params.poll_rate) {
+			stats->mode = RINGBUF_SCHED_POLL;
+			stats->npoll++;
+		}
+		return n;
+	}
+
+	if (stats->mode == RINGBUF_SCHED_POLL) {
+		if (++s->idle < s->params.poll_rounds) {
+			for (unsigned i = 0; i < SPINLOCK_BACKOFF_MAX; i++) {
+				SPINLOCK_BACKOFF_HOOK;
+			}
+			return 0;
+		}
+		stats->mode = RINGBUF_SCHED_INTR;
+		stats->nintr++;
+	}
+	sched_sleep(s);
+	return 0;
+}
+
+/*
+ * ringbuf_sched_notify: wake up the consumer, if it is sleeping.  The
+ * producers should call it after producing the records.
+ */
+void
+ringbuf_sched_notify(ringbuf_sched_t *s)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&s->sleeping, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s->seq, 1, memory_order_relaxed);
+		futex_wake(&s->seq, 1);
+	}
+}
+
+/*
+ * ringbuf_sched_stats: get the statistics, including the current mode.
+ */
+void
+ringbuf_sched_stats(const ringbuf_sched_t *s, ringbuf_sched_stats_t *stats)
+{
+	*stats = s->stats;
+}
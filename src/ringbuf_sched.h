@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_SCHED_H_
+#define _RINGBUF_SCHED_H_
+
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_sched ringbuf_sched_t;
+
+typedef struct {
+	unsigned	budget;		/* records per ring per round */
+	size_t		budget_bytes;	/* payload bytes, zero if unlimited */
+	unsigned	poll_rounds;	/* idle rounds before blocking */
+	unsigned	poll_rate;	/* records per round to resume polling */
+} ringbuf_sched_params_t;
+
+/* Modes. */
+#define	RINGBUF_SCHED_POLL	0	/* busy-polling */
+#define	RINGBUF_SCHED_INTR	1	/* blocking, woken up by producers */
+
+typedef struct {
+	uint64_t	nrounds;
+	uint64_t	nrecords;
+	uint64_t	nbudget;	/* rings left with budget exhausted */
+	uint64_t	nsleeps;
+	uint64_t	npoll;		/* switches to the polling mode */
+	uint64_t	nintr;		/* switches to the blocking mode */
+	unsigned	mode;
+} ringbuf_sched_stats_t;
+
+typedef void (*ringbuf_sched_handler_t)(void *, unsigned, ringbuf_frame_t *);
+
+ringbuf_sched_t *ringbuf_sched_create(unsigned,
+		    const ringbuf_sched_params_t *);
+void		ringbuf_sched_destroy(ringbuf_sched_t *);
+ringbuf_frame_iter_t *ringbuf_sched_add(ringbuf_sched_t *, unsigned,
+		    ringbuf_t *, void *);
+
+unsigned	ringbuf_sched_poll(ringbuf_sched_t *,
+		    ringbuf_sched_handler_t, void *);
+void		ringbuf_sched_notify(ringbuf_sched_t *);
+void		ringbuf_sched_stats(const ringbuf_sched_t *,
+		    ringbuf_sched_stats_t *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Load-balancing producer front-end across a set of rings.
+ *
+ * Each ring of the set has its own consumer.  When the order of the
+ * records does not matter, the producer spreads them using the power
+ * of two choices: it samples two random rings and acquires from the one
+ * with the lower usage, falling back to the other one if it is full.
+ * Compared to picking one random ring, this keeps the maximum load close
+ * to the average, while reading only two rings per record.
+ *
+ * Cached usage
+ *
+ *	Reading the usage of a ring touches the cache lines written by
+ *	its producers and the consumer.  Instead, each producer keeps its
+ *	own estimate of the usage of every ring: it adds the space of its
+ *	own records and re-reads the actual value only every SET_REFRESH
+ *	records to the ring (or when the ring is found full).
+ *
+ * The set is private to the producer (with a worker registered in each
+ * ring); there is no shared state other than the rings themselves.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "ringbuf_set.h"
+#include "utils.h"
+
+/* Number of own records to a ring before re-reading its usage. */
+#define	SET_REFRESH	16
+
+struct ringbuf_set {
+	uint32_t		seed;
+	unsigned		nrings;
+	struct set_ring {
+		ringbuf_t *		rbuf;
+		ringbuf_worker_t *	w;
+		void *			buf;
+		size_t			usage;	/* cached estimate */
+		unsigned		age;	/* records since the refresh */
+	} ring[];
+};
+
+/*
+ * ringbuf_set_create: construct the set of the given number of rings.
+ */
+ringbuf_set_t *
+ringbuf_set_create(unsigned nrings)
+{
+	ringbuf_set_t *s;
+
+	if (nrings == 0) {
+		return NULL;
+	}
+	s = calloc(1, offsetof(ringbuf_set_t, ring[nrings]));
+	if (s == NULL) {
+		return NULL;
+	}
+	/* Different producers sample differently. */
+	s->seed = (uint32_t)((uintptr_t)s >> 4) | 1;
+	s->nrings = nrings;
+	return s;
+}
+
+void
+ringbuf_set_destroy(ringbuf_set_t *s)
+{
+	free(s);
+}
+
+/*
+ * ringbuf_set_add: set the ring buffer, the worker of the producer and
+ * the data space for the given index.
+ */
+void
+ringbuf_set_add(ringbuf_set_t *s, unsigned i, ringbuf_t *rbuf,
+    ringbuf_worker_t *w, void *buf)
+{
+	struct set_ring *r = &s->ring[i];
+
+	ASSERT(i < s->nrings);
+	r->rbuf = rbuf;
+	r->w = w;
+	r->buf = buf;
+	r->usage = 0;
+	r->age = SET_REFRESH;
+}
+
+static inline uint32_t
+set_random(ringbuf_set_t *s)
+{
+	/* Xorshift. */
+	uint32_t x = s->seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	s->seed = x;
+	return x;
+}
+
+static inline size_t
+set_usage(struct set_ring *r)
+{
+	if (r->age >= SET_REFRESH) {
+		r->usage = ringbuf_get_usage(r->rbuf);
+		r->age = 0;
+	}
+	return r->usage;
+}
+
+static ringbuf_frame_t *
+set_acquire(struct set_ring *r, size_t len, const ringbuf_frame_opts_t *opts)
+{
+	ringbuf_frame_t *f;
+
+	f = ringbuf_frame_acquire(r->rbuf, r->w, r->buf, len, opts);
+	if (f == NULL) {
+		/* Full: the estimate is off, re-read it next time. */
+		r->age = SET_REFRESH;
+		return NULL;
+	}
+	r->usage += ringbuf_frame_size(len, opts);
+	r->age++;
+	return f;
+}
+
+/*
+ * ringbuf_set_acquire: acquire a record in the less used of two randomly
+ * chosen rings or, if it is full, in the other one.
+ *
+ * => Returns the record and sets the index of its ring, to be passed to
+ *    ringbuf_set_produce(); returns NULL if both rings are full.
+ */
+ringbuf_frame_t *
+ringbuf_set_acquire(ringbuf_set_t *s, size_t len,
+    const ringbuf_frame_opts_t *opts, unsigned *ring)
+{
+	unsigned i, j;
+	ringbuf_frame_t *f;
+
+	if (s->nrings == 1) {
+		*ring = 0;
+		return set_acquire(&s->ring[0], len, opts);
+	}
+
+	/* Two distinct rings, the first being the less used. */
+	i = set_random(s) % s->nrings;
+	j = set_random(s) % (s->nrings - 1);
+	j += (j >= i);
+	if (set_usage(&s->ring[j]) < set_usage(&s->ring[i])) {
+		const unsigned t = i;
+		i = j;
+		j = t;
+	}
+
+	if ((f = set_acquire(&s->ring[i], len, opts)) != NULL) {
+		*ring = i;
+		return f;
+	}
+	if ((f = set_acquire(&s->ring[j], len, opts)) != NULL) {
+		*ring = j;
+		return f;
+	}
+	return NULL;
+}
+
+/*
+ * ringbuf_set_produce: indicate that the record acquired in the given
+ * ring is ready.
+ */
+void
+ringbuf_set_produce(ringbuf_set_t *s, unsigned i, ringbuf_frame_t *f)
+{
+	struct set_ring *r = &s->ring[i];
+
+	ASSERT(i < s->nrings);
+	ringbuf_frame_produce(r->rbuf, r->w, f);
+}
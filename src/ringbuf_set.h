@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_SET_H_
+#define _RINGBUF_SET_H_
+
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+typedef struct ringbuf_set ringbuf_set_t;
+
+ringbuf_set_t *	ringbuf_set_create(unsigned);
+void		ringbuf_set_destroy(ringbuf_set_t *);
+void		ringbuf_set_add(ringbuf_set_t *, unsigned, ringbuf_t *,
+		    ringbuf_worker_t *, void *);
+
+ringbuf_frame_t *ringbuf_set_acquire(ringbuf_set_t *, size_t,
+		    const ringbuf_frame_opts_t *, unsigned *);
+void		ringbuf_set_produce(ringbuf_set_t *, unsigned,
+		    ringbuf_frame_t *);
+
+__END_DECLS
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Parallel fill of a single reservation.
+ *
+ * The worker acquires the space as usual and splits the range into the
+ * parts, which are filled by the helper threads (the worker itself may
+ * fill one of them).  Each helper signals the completion of its part by
+ * decrementing the counter; the last one produces the range on behalf
+ * of the worker, i.e. the record becomes visible to the consumer only
+ * once all parts are done.  Note: ringbuf_produce() only clears the
+ * 'seen' offset of the worker, so it may be called by any thread.
+ *
+ * The worker must not acquire again until the produce is done, which
+ * can be waited for using ringbuf_split_wait().  The waiter spins for a
+ * few rounds and then sleeps on the 'done' word using futex(2): it sets
+ * the 'waiting' flag, issues a full memory barrier and re-checks the
+ * word; the last helper sets the word, issues a full memory barrier and
+ * checks the flag.  Either the waiter observes the new value or the
+ * helper observes the flag, so the system call is made only when the
+ * waiter is (about to be) sleeping.  The state may be freed once the
+ * wait returns, therefore the helper marks the produce as complete with
+ * its last access to the state, after the wake up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+
+#include "ringbuf_split.h"
+#include "utils.h"
+
+/* Number of the back-off rounds before going to sleep. */
+#define	SPLIT_SPIN_ROUNDS	16
+
+/* The values of the 'done' word. */
+#define	SPLIT_PENDING		0
+#define	SPLIT_PRODUCED		1	/* the helper still accesses the state */
+#define	SPLIT_COMPLETE		2
+
+/*
+ * ringbuf_split_init: initialise the state for the range of the given
+ * length, just acquired by the worker, to be filled in 'nparts' parts.
+ */
+void
+ringbuf_split_init(ringbuf_split_t *sp, ringbuf_t *rbuf,
+    ringbuf_worker_t *w, size_t len, unsigned nparts)
+{
+	ASSERT(nparts > 0);
+	sp->rbuf = rbuf;
+	sp->w = w;
+	sp->len = len;
+	sp->nparts = nparts;
+	sp->pending = nparts;
+	sp->done = SPLIT_PENDING;
+	sp->waiting = 0;
+}
+
+/*
+ * ringbuf_split_part: return the length of the given part and its offset
+ * relative to the start of the range.  The parts are aligned to the cache
+ * line size, so that the helpers do not share the cache lines; some parts
+ * may be empty if the range is small.
+ */
+size_t
+ringbuf_split_part(const ringbuf_split_t *sp, unsigned i, size_t *offp)
+{
+	const size_t chunk = roundup2((sp->len + sp->nparts - 1) / sp->nparts,
+	    CACHE_LINE_SIZE);
+	const size_t off = MIN((size_t)i * chunk, sp->len);
+
+	ASSERT(i < sp->nparts);
+	*offp = off;
+	return MIN(chunk, sp->len - off);
+}
+
+/*
+ * ringbuf_split_done: indicate that a part is filled.  The last part
+ * produces the range.
+ */
+void
+ringbuf_split_done(ringbuf_split_t *sp)
+{
+	/*
+	 * Release the writes of this part; the last decrement acquires
+	 * the writes of all parts before producing.
+	 */
+	if (atomic_fetch_sub_explicit(&sp->pending, 1,
+	    memory_order_acq_rel) != 1) {
+		return;
+	}
+	ringbuf_produce(sp->rbuf, sp->w);
+	atomic_store_explicit(&sp->done, SPLIT_PRODUCED, memory_order_release);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&sp->waiting, memory_order_relaxed)) {
+		futex_wake(&sp->done, 1);
+	}
+	/* The last access: the waiter may free the state after it. */
+	atomic_store_explicit(&sp->done, SPLIT_COMPLETE, memory_order_release);
+}
+
+/*
+ * ringbuf_split_wait: wait until all parts are done and the range is
+ * produced.  Only the worker.
+ */
+void
+ringbuf_split_wait(ringbuf_split_t *sp)
+{
+	unsigned count = SPINLOCK_BACKOFF_MIN, rounds = 0;
+	uint32_t done;
+
+	while ((done = atomic_load_explicit(&sp->done,
+	    memory_order_acquire)) != SPLIT_COMPLETE) {
+		if (rounds++ < SPLIT_SPIN_ROUNDS) {
+			SPINLOCK_BACKOFF(count);
+			continue;
+		}
+		if (done == SPLIT_PRODUCED) {
+			/* The helper is about to complete. */
+			sched_yield();
+			continue;
+		}
+
+		/*
+		 * Announce that we are going to sleep and re-check.
+		 * Note: futex_wait() will not sleep if 'done' changed.
+		 */
+		atomic_store_explicit(&sp->waiting, 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+		if (atomic_load_explicit(&sp->done,
+		    memory_order_relaxed) == SPLIT_PENDING) {
+			futex_wait(&sp->done, SPLIT_PENDING);
+		}
+		atomic_store_explicit(&sp->waiting, 0, memory_order_relaxed);
+	}
+}
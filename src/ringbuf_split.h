@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_SPLIT_H_
+#define _RINGBUF_SPLIT_H_
+
+#include <inttypes.h>
+
+#include "ringbuf.h"
+
+__BEGIN_DECLS
+
+/*
+ * The state of a reservation filled in parts, possibly concurrently.
+ */
+typedef struct {
+	ringbuf_t *		rbuf;
+	ringbuf_worker_t *	w;
+	size_t			len;
+	unsigned		nparts;
+	volatile unsigned	pending;
+	volatile uint32_t	done;
+	volatile uint32_t	waiting;
+} ringbuf_split_t;
+
+void		ringbuf_split_init(ringbuf_split_t *, ringbuf_t *,
+		    ringbuf_worker_t *, size_t, unsigned);
+size_t		ringbuf_split_part(const ringbuf_split_t *, unsigned, size_t *);
+void		ringbuf_split_done(ringbuf_split_t *);
+void		ringbuf_split_wait(ringbuf_split_t *);
+
+__END_DECLS
+
+#endif
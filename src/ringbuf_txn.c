@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Atomic publish of a group of framed records across multiple rings.
+ *
+ * Each producer owns a slot in the shared transaction table.  A slot
+ * has a state word, containing the epoch and the state of the current
+ * transaction, and a reference count of its records not yet passed by
+ * the consumers.
+ *
+ * - The producer starts a transaction by incrementing the epoch and
+ *   acquires a record in each ring; the records carry the transaction
+ *   ID (the epoch and the slot index) as an optional field.
+ *
+ * - Once the records are filled, the producer produces all of them and
+ *   then atomically sets the state to committed (or aborted).
+ *
+ * - The consumer iterator stops at a record of an open transaction and
+ *   resumes once it is committed; the records of an aborted transaction
+ *   are skipped.  Since a single store publishes all records, either
+ *   all of them are visible to the consumers or none.  Each consumer
+ *   decrements the reference count when releasing a record, including
+ *   the skipped ones (aborted or corrupt).
+ *
+ * A slot cannot be reused until all records of its last transaction are
+ * released, therefore the state observed by the consumer always refers to
+ * the transaction of the record.  Note: an open transaction blocks the
+ * records following it in each ring, so it should be short.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ringbuf_txn.h"
+#include "utils.h"
+
+#define	TXN_ID(epoch, slot)	(((uint64_t)(epoch) << 32) | (slot))
+#define	TXN_SLOT(id)		((uint32_t)(id))
+#define	TXN_EPOCH(id)		((uint32_t)((id) >> 32))
+
+/* The state word: the epoch and the state of the transaction. */
+#define	TXN_STATE(epoch, st)	(((uint64_t)(epoch) << 32) | (st))
+#define	TXN_STATE_ST(state)	((unsigned)(uint32_t)(state))
+
+struct txn_slot {
+	volatile uint64_t	state;
+	volatile uint32_t	refs;
+	uint8_t			_pad[CACHE_LINE_SIZE -
+				    sizeof(uint64_t) - sizeof(uint32_t)];
+};
+
+struct ringbuf_txn {
+	unsigned		nslots;
+	uint8_t			_pad[CACHE_LINE_SIZE - sizeof(unsigned)];
+	struct txn_slot		slot[];
+};
+
+/*
+ * ringbuf_txn_get_size: return the size of the transaction table.
+ */
+size_t
+ringbuf_txn_get_size(unsigned nslots)
+{
+	return offsetof(ringbuf_txn_t, slot[nslots]);
+}
+
+/*
+ * ringbuf_txn_setup: initialise the table with a slot for each producer.
+ */
+int
+ringbuf_txn_setup(ringbuf_txn_t *t, unsigned nslots)
+{
+	if (nslots == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	memset(t, 0, ringbuf_txn_get_size(nslots));
+	t->nslots = nslots;
+	return 0;
+}
+
+static void
+txn_publish(ringbuf_txn_t *t, unsigned slot, ringbuf_txn_rec_t *recs,
+    unsigned n, unsigned st)
+{
+	struct txn_slot *s = &t->slot[slot];
+	const uint32_t epoch = TXN_EPOCH(s->state);
+
+	ASSERT(TXN_STATE_ST(s->state) == RINGBUF_TXN_OPEN);
+
+	/*
+	 * Produce all records; they remain blocked until the state
+	 * is set.  Note: ringbuf_produce() issues a release barrier.
+	 */
+	for (unsigned i = 0; i < n; i++) {
+		if (recs[i].frame) {
+			ringbuf_frame_produce(recs[i].rbuf, recs[i].w,
+			    recs[i].frame);
+		}
+	}
+	atomic_store_explicit(&s->state, TXN_STATE(epoch, st),
+	    memory_order_release);
+}
+
+/*
+ * ringbuf_txn_acquire: start a transaction in the given slot and acquire
+ * a record in each ring.
+ *
+ * => On success, returns 0; the records must be filled and then either
+ *    committed or aborted.
+ * => Returns -1 with errno set to EBUSY if the records of the previous
+ *    transaction are not yet passed by the consumers, or ENOBUFS if any
+ *    of the rings does not have the space (the acquired records are
+ *    aborted).
+ */
+int
+ringbuf_txn_acquire(ringbuf_txn_t *t, unsigned slot,
+    ringbuf_txn_rec_t *recs, unsigned n)
+{
+	struct txn_slot *s = &t->slot[slot];
+	uint32_t epoch;
+	unsigned i;
+
+	ASSERT(slot < t->nslots);
+
+	if (atomic_load_explicit(&s->refs, memory_order_acquire)) {
+		errno = EBUSY;
+		return -1;
+	}
+	epoch = TXN_EPOCH(s->state) + 1;
+	atomic_store_explicit(&s->state, TXN_STATE(epoch, RINGBUF_TXN_OPEN),
+	    memory_order_relaxed);
+
+	for (i = 0; i < n; i++) {
+		ringbuf_txn_rec_t *rec = &recs[i];
+		ringbuf_frame_opts_t opts = { .deadline = 0 };
+
+		if (rec->opts) {
+			opts = *rec->opts;
+		}
+		opts.txn = TXN_ID(epoch, slot);
+		rec->frame = ringbuf_frame_acquire(rec->rbuf, rec->w,
+		    rec->buf, rec->len, &opts);
+		if (rec->frame == NULL) {
+			break;
+		}
+	}
+
+	/*
+	 * The reference count becomes visible to the consumers together
+	 * with the records (when they are produced).
+	 */
+	atomic_store_explicit(&s->refs, i, memory_order_relaxed);
+	if (i < n) {
+		txn_publish(t, slot, recs, i, RINGBUF_TXN_ABORTED);
+		while (i < n) {
+			recs[i++].frame = NULL;
+		}
+		errno = ENOBUFS;
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * ringbuf_txn_commit: produce the records and make them visible.
+ */
+void
+ringbuf_txn_commit(ringbuf_txn_t *t, unsigned slot,
+    ringbuf_txn_rec_t *recs, unsigned n)
+{
+	txn_publish(t, slot, recs, n, RINGBUF_TXN_COMMITTED);
+}
+
+/*
+ * ringbuf_txn_abort: produce the records, which the consumers skip.
+ */
+void
+ringbuf_txn_abort(ringbuf_txn_t *t, unsigned slot,
+    ringbuf_txn_rec_t *recs, unsigned n)
+{
+	txn_publish(t, slot, recs, n, RINGBUF_TXN_ABORTED);
+}
+
+/*
+ * ringbuf_txn_state: return the state of the transaction with the given
+ * ID (of a consumed record).
+ */
+unsigned
+ringbuf_txn_state(ringbuf_txn_t *t, uint64_t id)
+{
+	struct txn_slot *s = &t->slot[TXN_SLOT(id)];
+	const uint64_t state = atomic_load_explicit(&s->state,
+	    memory_order_acquire);
+
+	ASSERT(TXN_SLOT(id) < t->nslots);
+	ASSERT(TXN_EPOCH(state) == TXN_EPOCH(id));
+	return TXN_STATE_ST(state);
+}
+
+/*
+ * ringbuf_txn_done: indicate that the consumer released the record of
+ * the transaction.
+ *
+ * => The ID of a corrupt record may be bogus: the ID which is not of the
+ *    current transaction of its slot is ignored.
+ */
+void
+ringbuf_txn_done(ringbuf_txn_t *t, uint64_t id)
+{
+	struct txn_slot *s;
+
+	if (__predict_false(TXN_SLOT(id) >= t->nslots)) {
+		return;
+	}
+	s = &t->slot[TXN_SLOT(id)];
+	if (__predict_false(TXN_EPOCH(s->state) != TXN_EPOCH(id) ||
+	    s->refs == 0)) {
+		return;
+	}
+	atomic_fetch_sub_explicit(&s->refs, 1, memory_order_release);
+}
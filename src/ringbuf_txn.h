@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#ifndef _RINGBUF_TXN_H_
+#define _RINGBUF_TXN_H_
+
+#include <inttypes.h>
+
+#include "ringbuf_frame.h"
+
+__BEGIN_DECLS
+
+/*
+ * A record of the transaction: the ring buffer, its worker and data
+ * space, the payload length and options (may be NULL).  The acquired
+ * record is returned in 'frame'.
+ */
+typedef struct {
+	ringbuf_t *		rbuf;
+	ringbuf_worker_t *	w;
+	void *			buf;
+	size_t			len;
+	const ringbuf_frame_opts_t *opts;
+	ringbuf_frame_t *	frame;
+} ringbuf_txn_rec_t;
+
+/* Transaction states. */
+#define	RINGBUF_TXN_OPEN	1
+#define	RINGBUF_TXN_COMMITTED	2
+#define	RINGBUF_TXN_ABORTED	3
+
+size_t		ringbuf_txn_get_size(unsigned);
+int		ringbuf_txn_setup(ringbuf_txn_t *, unsigned);
+
+int		ringbuf_txn_acquire(ringbuf_txn_t *, unsigned,
+		    ringbuf_txn_rec_t *, unsigned);
+void		ringbuf_txn_commit(ringbuf_txn_t *, unsigned,
+		    ringbuf_txn_rec_t *, unsigned);
+void		ringbuf_txn_abort(ringbuf_txn_t *, unsigned,
+		    ringbuf_txn_rec_t *, unsigned);
+
+unsigned	ringbuf_txn_state(ringbuf_txn_t *, uint64_t);
+void		ringbuf_txn_done(ringbuf_txn_t *, uint64_t);
+
+__END_DECLS
+
+#endif
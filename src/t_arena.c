@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_arena.h"
+
+#define	NTHREADS	4
+#define	NITERS		100000
+#define	NLIVE		8
+
+static ringbuf_arena_t *	arena;
+
+static void
+test_basic(void)
+{
+	ringbuf_arena_t *a = malloc(ringbuf_arena_get_size(1, 1024));
+	ringbuf_worker_t *w;
+	void *p[8], *q;
+	int ret;
+
+	/* Invalid parameters. */
+	ret = ringbuf_arena_setup(a, 1, 1000);
+	assert(ret == -1);
+
+	ret = ringbuf_arena_setup(a, 1, 1024);
+	assert(ret == 0); (void)ret;
+	w = ringbuf_arena_register(a, 0);
+
+	/* Too large. */
+	q = ringbuf_arena_alloc(a, w, 1024);
+	assert(q == NULL);
+
+	/* Fill: eight blocks of 112 + 16 bytes; the last does not fit. */
+	for (unsigned i = 0; i < 7; i++) {
+		p[i] = ringbuf_arena_alloc(a, w, 100);
+		assert(p[i] != NULL);
+		assert(((uintptr_t)p[i] & 15) == 0);
+		memset(p[i], i, 100);
+	}
+	q = ringbuf_arena_alloc(a, w, 100);
+	assert(q == NULL);
+
+	/* Out of order: nothing is reclaimed. */
+	ringbuf_arena_free(a, p[1]);
+	ringbuf_arena_free(a, p[2]);
+	q = ringbuf_arena_alloc(a, w, 100);
+	assert(q == NULL);
+
+	/* Free the head: three blocks reclaimed at once. */
+	ringbuf_arena_free(a, p[0]);
+	for (unsigned i = 0; i < 3; i++) {
+		q = ringbuf_arena_alloc(a, w, 100);
+		assert(q != NULL);
+		p[i] = q;
+	}
+	q = ringbuf_arena_alloc(a, w, 100);
+	assert(q == NULL);
+	for (unsigned i = 3; i < 7; i++) {
+		assert(((uint8_t *)p[i])[99] == i);
+	}
+
+	/* Free all in the allocation order. */
+	for (unsigned i = 3; i < 7; i++) {
+		ringbuf_arena_free(a, p[i]);
+	}
+	for (unsigned i = 0; i < 3; i++) {
+		ringbuf_arena_free(a, p[i]);
+	}
+	q = ringbuf_arena_alloc(a, w, 500);
+	assert(q != NULL);
+	ringbuf_arena_free(a, q);
+	free(a);
+}
+
+static void *
+worker(void *arg)
+{
+	const unsigned id = (uintptr_t)arg;
+	ringbuf_worker_t *w = ringbuf_arena_register(arena, id);
+	uint8_t *live[NLIVE];
+	size_t lens[NLIVE];
+	unsigned head = 0, tail = 0;
+
+	for (unsigned i = 0; i < NITERS; i++) {
+		const size_t len = (i * 7 + id) % 200 + 1;
+		uint8_t *p;
+
+		/*
+		 * Keep a few objects alive; free them in the FIFO order.
+		 * If out of space and nothing to free, then wait for the
+		 * other threads to free their blocks.
+		 */
+		while (tail - head == NLIVE ||
+		    (p = ringbuf_arena_alloc(arena, w, len)) == NULL) {
+			if (tail == head) {
+				sched_yield();
+				continue;
+			}
+			for (size_t j = 0; j < lens[head % NLIVE]; j++) {
+				assert(live[head % NLIVE][j] == (uint8_t)id);
+			}
+			ringbuf_arena_free(arena, live[head % NLIVE]);
+			head++;
+		}
+		memset(p, id, len);
+		live[tail % NLIVE] = p;
+		lens[tail % NLIVE] = len;
+		tail++;
+	}
+	while (head != tail) {
+		ringbuf_arena_free(arena, live[head++ % NLIVE]);
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	const size_t space = 16 * 1024;
+	pthread_t thr[NTHREADS];
+	int ret;
+
+	arena = malloc(ringbuf_arena_get_size(NTHREADS, space));
+	ret = ringbuf_arena_setup(arena, NTHREADS, space);
+	assert(ret == 0); (void)ret;
+
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		pthread_create(&thr[i], NULL, worker, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		pthread_join(thr[i], NULL);
+	}
+	free(arena);
+}
+
+int
+main(void)
+{
+	test_basic();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
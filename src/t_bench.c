@@ -0,0 +1,789 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+/*
+ * Micro-benchmarks: the single-threaded cost of the produce/consume
+ * cycle per record, for the raw ring buffer and the framed records
+ * (with and without the per-record CRC32C).  Besides the throughput,
+ * the tail (99th percentile) latency of the cycle of a batch is taken.
+ * The request/response channel round-trip is compared against the
+ * mutex and condition variable hand-off between two threads.
+ *
+ * Comparison mode: a single run is noisy, therefore the benchmarks are
+ * repeated (-n) and the samples of each repetition are stored as JSON in
+ * the results directory (-d), keyed by the revision (-r) and the CPU
+ * model.  Given a base revision (-b), the samples are compared against
+ * its results on the same CPU model: for each scenario and metric, the
+ * delta of the medians with the bootstrap 95% confidence interval and
+ * the p-value of the Mann-Whitney U test (the normal approximation with
+ * the tie correction) are reported.  The delta is flagged as significant
+ * if p < 0.05 and the interval excludes zero; a significant slow-down is
+ * a regression and the exit status is then non-zero.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <err.h>
+
+#include "ringbuf_frame.h"
+#include "ringbuf_chan.h"
+#include "crc32c.h"
+
+#define	RBUF_SIZE	(64 * 1024)
+#define	BATCH		64
+#define	NRECORDS	(4 * 1000 * 1000)
+#define	NBATCHES	(NRECORDS / BATCH)
+#define	NCALLS		(64 * 1024)
+
+#define	MAXREPS		100
+#define	BOOT_ROUNDS	2000
+#define	ALPHA		0.05
+
+typedef struct {
+	const char *	name;
+	uint64_t	(*func)(size_t, bool, uint64_t *);
+	size_t		len;
+	bool		crc;
+	unsigned	nops;
+} bench_t;
+
+/*
+ * The samples of a scenario: ns/op and the p99 latency of the batch
+ * cycle in nanoseconds, one per repetition.
+ */
+typedef struct {
+	char		name[32];
+	unsigned	n;
+	double		nsop[MAXREPS];
+	double		p99[MAXREPS];
+} bench_res_t;
+
+static ringbuf_t *	ringbuf;
+static ringbuf_worker_t *worker;
+static uint64_t		rbuf[RBUF_SIZE / sizeof(uint64_t)];
+static uint64_t		lat[NBATCHES];
+static volatile uint64_t sink;
+
+static uint64_t
+now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+setup_ring(void)
+{
+	size_t size;
+
+	ringbuf_get_sizes(1, &size, NULL);
+	if ((ringbuf = malloc(size)) == NULL) {
+		err(EXIT_FAILURE, "malloc");
+	}
+	ringbuf_setup(ringbuf, 1, sizeof(rbuf));
+	worker = ringbuf_register(ringbuf, 0);
+}
+
+/*
+ * Raw ring buffer: produce a batch of records, then consume them all.
+ */
+static uint64_t
+bench_raw(size_t len, bool crc, uint64_t *blat)
+{
+	uint8_t *buf = (void *)rbuf;
+	uint64_t sum = 0;
+
+	(void)crc;
+	for (unsigned n = 0; n < NRECORDS; n += BATCH) {
+		const uint64_t start = now_nsec();
+		size_t off, nbytes;
+
+		for (unsigned i = 0; i < BATCH; i++) {
+			ssize_t ret;
+
+			if ((ret = ringbuf_acquire(ringbuf, worker, len)) == -1) {
+				errx(EXIT_FAILURE, "ringbuf_acquire");
+			}
+			memset(&buf[ret], i, len);
+			ringbuf_produce(ringbuf, worker);
+		}
+		while ((nbytes = ringbuf_consume(ringbuf, &off)) != 0) {
+			for (size_t pos = 0; pos < nbytes; pos += len) {
+				sum += buf[off + pos];
+			}
+			ringbuf_release(ringbuf, nbytes);
+		}
+		blat[n / BATCH] = now_nsec() - start;
+	}
+	return sum;
+}
+
+/*
+ * Framed records: produce a batch, then iterate and release.
+ */
+static uint64_t
+bench_frame(size_t len, bool crc, uint64_t *blat)
+{
+	const ringbuf_frame_opts_t opts = { .crc = crc };
+	ringbuf_frame_iter_t it;
+	uint64_t sum = 0;
+
+	ringbuf_frame_iter_init(&it, ringbuf, rbuf);
+	for (unsigned n = 0; n < NRECORDS; n += BATCH) {
+		const uint64_t start = now_nsec();
+
+		for (unsigned i = 0; i < BATCH; i++) {
+			ringbuf_frame_t *f;
+
+			f = ringbuf_frame_acquire(ringbuf, worker, rbuf,
+			    len, &opts);
+			if (f == NULL) {
+				errx(EXIT_FAILURE, "ringbuf_frame_acquire");
+			}
+			memset(ringbuf_frame_data(f), i, len);
+			ringbuf_frame_produce(ringbuf, worker, f);
+		}
+		while (ringbuf_frame_consume(&it, 0)) {
+			ringbuf_frame_t *f;
+
+			while ((f = ringbuf_frame_next(&it)) != NULL) {
+				sum += *(uint8_t *)ringbuf_frame_data(f);
+			}
+			ringbuf_frame_release(&it);
+		}
+		blat[n / BATCH] = now_nsec() - start;
+	}
+	if (it.ncorrupt) {
+		errx(EXIT_FAILURE, "corrupt records");
+	}
+	return sum;
+}
+
+/*
+ * CRC32C alone, over the records of the given length.
+ */
+static uint64_t
+bench_crc32c(size_t len, bool crc, uint64_t *blat)
+{
+	uint64_t sum = 0;
+
+	(void)crc;
+	memset(rbuf, 0x5a, len);
+	for (unsigned n = 0; n < NRECORDS; n += BATCH) {
+		const uint64_t start = now_nsec();
+
+		for (unsigned i = 0; i < BATCH; i++) {
+			sum += ringbuf_crc32c(n + i, rbuf, len);
+		}
+		blat[n / BATCH] = now_nsec() - start;
+	}
+	return sum;
+}
+
+/*
+ * Request/response round-trip: a server thread echoes the requests.
+ */
+
+static volatile bool	server_stop;
+
+static size_t
+echo_handler(void *arg, const void *req, size_t len, void *resp, size_t max)
+{
+	(void)arg;
+	len = len < max ? len : max;
+	memcpy(resp, req, len);
+	return len;
+}
+
+static void *
+chan_server(void *arg)
+{
+	ringbuf_chan_t *ch = arg;
+
+	while (!server_stop) {
+		if (ringbuf_chan_serve(ch, echo_handler, NULL) == 0) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static uint64_t
+bench_chan(size_t len, bool crc, uint64_t *blat)
+{
+	const size_t size = ringbuf_chan_get_size(1, 4096, len);
+	ringbuf_chan_t *ch;
+	uint8_t req[256], resp[256];
+	uint64_t sum = 0;
+	pthread_t thr;
+
+	(void)crc;
+	if ((ch = malloc(size)) == NULL ||
+	    ringbuf_chan_setup(ch, 1, 4096, len) == -1) {
+		err(EXIT_FAILURE, "ringbuf_chan_setup");
+	}
+	memset(req, 0x5a, len);
+	server_stop = false;
+	pthread_create(&thr, NULL, chan_server, ch);
+
+	for (unsigned n = 0; n < NCALLS; n += BATCH) {
+		const uint64_t start = now_nsec();
+
+		for (unsigned i = 0; i < BATCH; i++) {
+			if (ringbuf_chan_call(ch, 0, req, len, resp, len,
+			    RINGBUF_CHAN_SLEEP) == -1) {
+				err(EXIT_FAILURE, "ringbuf_chan_call");
+			}
+			sum += resp[0];
+		}
+		blat[n / BATCH] = now_nsec() - start;
+	}
+	server_stop = true;
+	pthread_join(thr, NULL);
+	free(ch);
+	return sum;
+}
+
+/*
+ * The same round-trip using a mutex and the condition variables.
+ */
+
+static struct {
+	pthread_mutex_t	lock;
+	pthread_cond_t	reqcv;
+	pthread_cond_t	respcv;
+	bool		pending;
+	bool		done;
+	size_t		len;
+	uint8_t		req[256];
+	uint8_t		resp[256];
+} mtx_chan = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.reqcv = PTHREAD_COND_INITIALIZER,
+	.respcv = PTHREAD_COND_INITIALIZER,
+};
+
+static void *
+mutex_server(void *arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&mtx_chan.lock);
+	for (;;) {
+		while (!mtx_chan.pending && !server_stop) {
+			pthread_cond_wait(&mtx_chan.reqcv, &mtx_chan.lock);
+		}
+		if (!mtx_chan.pending) {
+			break;
+		}
+		mtx_chan.pending = false;
+		(void)echo_handler(NULL, mtx_chan.req, mtx_chan.len,
+		    mtx_chan.resp, sizeof(mtx_chan.resp));
+		mtx_chan.done = true;
+		pthread_cond_signal(&mtx_chan.respcv);
+	}
+	pthread_mutex_unlock(&mtx_chan.lock);
+	return NULL;
+}
+
+static uint64_t
+bench_mutex(size_t len, bool crc, uint64_t *blat)
+{
+	uint8_t req[256], resp[256];
+	uint64_t sum = 0;
+	pthread_t thr;
+
+	(void)crc;
+	memset(req, 0x5a, len);
+	server_stop = false;
+	pthread_create(&thr, NULL, mutex_server, NULL);
+
+	for (unsigned n = 0; n < NCALLS; n += BATCH) {
+		const uint64_t start = now_nsec();
+
+		for (unsigned i = 0; i < BATCH; i++) {
+			pthread_mutex_lock(&mtx_chan.lock);
+			memcpy(mtx_chan.req, req, len);
+			mtx_chan.len = len;
+			mtx_chan.pending = true;
+			pthread_cond_signal(&mtx_chan.reqcv);
+			while (!mtx_chan.done) {
+				pthread_cond_wait(&mtx_chan.respcv,
+				    &mtx_chan.lock);
+			}
+			mtx_chan.done = false;
+			memcpy(resp, mtx_chan.resp, len);
+			pthread_mutex_unlock(&mtx_chan.lock);
+			sum += resp[0];
+		}
+		blat[n / BATCH] = now_nsec() - start;
+	}
+	pthread_mutex_lock(&mtx_chan.lock);
+	server_stop = true;
+	pthread_cond_signal(&mtx_chan.reqcv);
+	pthread_mutex_unlock(&mtx_chan.lock);
+	pthread_join(thr, NULL);
+	return sum;
+}
+
+static const bench_t benchmarks[] = {
+	{ "raw/64",		bench_raw,	64,	false,	NRECORDS	},
+	{ "frame/16",		bench_frame,	16,	false,	NRECORDS	},
+	{ "frame/16/crc",	bench_frame,	16,	true,	NRECORDS	},
+	{ "frame/64",		bench_frame,	64,	false,	NRECORDS	},
+	{ "frame/64/crc",	bench_frame,	64,	true,	NRECORDS	},
+	{ "frame/256",		bench_frame,	256,	false,	NRECORDS	},
+	{ "frame/256/crc",	bench_frame,	256,	true,	NRECORDS	},
+	{ "crc32c/64",		bench_crc32c,	64,	false,	NRECORDS	},
+	{ "crc32c/256",		bench_crc32c,	256,	false,	NRECORDS	},
+	{ "chan/call/64",	bench_chan,	64,	false,	NCALLS		},
+	{ "mutex/call/64",	bench_mutex,	64,	false,	NCALLS		},
+};
+
+#define	NBENCH	(sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+	const double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static double
+median(const double *v, unsigned n)
+{
+	double s[MAXREPS];
+
+	memcpy(s, v, n * sizeof(double));
+	qsort(s, n, sizeof(double), cmp_double);
+	return (n % 2) ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+}
+
+/*
+ * Results: the CPU model (the file name of the results is derived
+ * from it) and the JSON load/store.
+ */
+
+static void
+cpu_model(char *buf, size_t len)
+{
+	char line[256];
+	FILE *fp;
+
+	snprintf(buf, len, "unknown");
+	if ((fp = fopen("/proc/cpuinfo", "r")) == NULL) {
+		return;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		char *p;
+
+		if (strncmp(line, "model name", 10) != 0 ||
+		    (p = strchr(line, ':')) == NULL) {
+			continue;
+		}
+		while (isspace((unsigned char)*++p))
+			;
+		/* Note: keep it a plain JSON string. */
+		p[strcspn(p, "\n\"\\")] = '\0';
+		snprintf(buf, len, "%s", p);
+		break;
+	}
+	fclose(fp);
+}
+
+static void
+result_path(char *path, size_t len, const char *dir, const char *rev,
+    const char *cpu)
+{
+	char slug[128];
+	size_t n = 0;
+
+	for (const char *p = cpu; *p && n < sizeof(slug) - 1; p++) {
+		if (isalnum((unsigned char)*p)) {
+			slug[n++] = *p;
+		} else if (n && slug[n - 1] != '-') {
+			slug[n++] = '-';
+		}
+	}
+	while (n && slug[n - 1] == '-') {
+		n--;
+	}
+	slug[n] = '\0';
+	snprintf(path, len, "%s/%s@%s.json", dir, rev, slug);
+}
+
+static void
+json_array(FILE *fp, const char *key, const double *v, unsigned n)
+{
+	fprintf(fp, "\"%s\": [", key);
+	for (unsigned i = 0; i < n; i++) {
+		fprintf(fp, "%s%.3f", i ? ", " : "", v[i]);
+	}
+	fprintf(fp, "]");
+}
+
+static void
+results_store(const char *path, const char *rev, const char *cpu,
+    const bench_res_t *res, unsigned nres)
+{
+	FILE *fp;
+
+	if ((fp = fopen(path, "w")) == NULL) {
+		err(EXIT_FAILURE, "%s", path);
+	}
+	fprintf(fp, "{\n  \"rev\": \"%s\",\n  \"cpu\": \"%s\",\n", rev, cpu);
+	fprintf(fp, "  \"reps\": %u,\n  \"results\": [\n", res[0].n);
+	for (unsigned i = 0; i < nres; i++) {
+		fprintf(fp, "    { \"name\": \"%s\", ", res[i].name);
+		json_array(fp, "ns_op", res[i].nsop, res[i].n);
+		fprintf(fp, ", ");
+		json_array(fp, "p99_ns", res[i].p99, res[i].n);
+		fprintf(fp, " }%s\n", i + 1 < nres ? "," : "");
+	}
+	fprintf(fp, "  ]\n}\n");
+	if (fclose(fp) == EOF) {
+		err(EXIT_FAILURE, "%s", path);
+	}
+}
+
+static const char *
+json_parse_array(const char *p, const char *key, double *v, unsigned *n)
+{
+	char pat[32];
+
+	snprintf(pat, sizeof(pat), "\"%s\": [", key);
+	if ((p = strstr(p, pat)) == NULL) {
+		return NULL;
+	}
+	p += strlen(pat);
+	for (*n = 0; *p != ']' && *n < MAXREPS; (*n)++) {
+		char *end;
+
+		v[*n] = strtod(p, &end);
+		if (end == p) {
+			return NULL;
+		}
+		p = end + strspn(end, ", ");
+	}
+	return p;
+}
+
+/*
+ * results_load: parse the results, as stored by results_store() (this
+ * is not a general JSON parser).  Returns the number of scenarios.
+ */
+static unsigned
+results_load(const char *path, bench_res_t *res, unsigned maxres)
+{
+	const char *p;
+	unsigned nres = 0, n;
+	char *text;
+	long len;
+	FILE *fp;
+
+	if ((fp = fopen(path, "r")) == NULL) {
+		err(EXIT_FAILURE, "%s", path);
+	}
+	if (fseek(fp, 0, SEEK_END) == -1 || (len = ftell(fp)) < 0 ||
+	    fseek(fp, 0, SEEK_SET) == -1) {
+		err(EXIT_FAILURE, "%s", path);
+	}
+	if ((text = calloc(1, len + 1)) == NULL) {
+		err(EXIT_FAILURE, "calloc");
+	}
+	if (fread(text, 1, len, fp) != (size_t)len) {
+		errx(EXIT_FAILURE, "%s: short read", path);
+	}
+	fclose(fp);
+
+	p = text;
+	while (nres < maxres && (p = strstr(p, "\"name\": \"")) != NULL) {
+		bench_res_t *r = &res[nres];
+		const size_t nlen = strcspn(p += 9, "\"");
+
+		if (nlen >= sizeof(r->name)) {
+			errx(EXIT_FAILURE, "%s: invalid name", path);
+		}
+		memcpy(r->name, p, nlen);
+		r->name[nlen] = '\0';
+
+		p = json_parse_array(p, "ns_op", r->nsop, &r->n);
+		if (p == NULL ||
+		    (p = json_parse_array(p, "p99_ns", r->p99, &n)) == NULL ||
+		    n != r->n || n == 0) {
+			errx(EXIT_FAILURE, "%s: invalid results", path);
+		}
+		nres++;
+	}
+	free(text);
+	return nres;
+}
+
+/*
+ * Statistics.
+ */
+
+/*
+ * mann_whitney: return the two-sided p-value of the Mann-Whitney U test,
+ * using the normal approximation with the tie and continuity corrections.
+ */
+static double
+mann_whitney(const double *x, unsigned nx, const double *y, unsigned ny)
+{
+	struct { double v; unsigned grp; } a[2 * MAXREPS], t;
+	const unsigned n = nx + ny;
+	double rx = 0, ties = 0, u, mu, sigma, z;
+	unsigned i, j;
+
+	for (i = 0; i < nx; i++) {
+		a[i].v = x[i], a[i].grp = 0;
+	}
+	for (i = 0; i < ny; i++) {
+		a[nx + i].v = y[i], a[nx + i].grp = 1;
+	}
+	for (i = 1; i < n; i++) {
+		t = a[i];
+		for (j = i; j > 0 && a[j - 1].v > t.v; j--) {
+			a[j] = a[j - 1];
+		}
+		a[j] = t;
+	}
+
+	/* Assign the ranks, averaging over the ties. */
+	for (i = 0; i < n; i = j) {
+		double rank, m;
+
+		for (j = i + 1; j < n && a[j].v == a[i].v; j++)
+			;
+		rank = (i + 1 + j) / 2.0;
+		m = j - i;
+		for (unsigned k = i; k < j; k++) {
+			rx += a[k].grp == 0 ? rank : 0;
+		}
+		ties += m * m * m - m;
+	}
+
+	u = rx - (double)nx * (nx + 1) / 2;
+	mu = (double)nx * ny / 2;
+	sigma = sqrt((double)nx * ny / 12 *
+	    ((n + 1) - ties / ((double)n * (n - 1))));
+	if (sigma == 0) {
+		return 1;
+	}
+	z = (fabs(u - mu) - 0.5) / sigma;
+	return z <= 0 ? 1 : erfc(z / sqrt(2));
+}
+
+static uint64_t
+xorshift64(uint64_t *s)
+{
+	uint64_t x = *s;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return *s = x;
+}
+
+/*
+ * bootstrap_ci: the 95% confidence interval of the relative delta of the
+ * medians (y over x), by resampling both samples.
+ */
+static void
+bootstrap_ci(const double *x, unsigned nx, const double *y, unsigned ny,
+    double *lo, double *hi)
+{
+	static double d[BOOT_ROUNDS];
+	uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+	for (unsigned b = 0; b < BOOT_ROUNDS; b++) {
+		double sx[MAXREPS], sy[MAXREPS], mx;
+
+		for (unsigned i = 0; i < nx; i++) {
+			sx[i] = x[xorshift64(&seed) % nx];
+		}
+		for (unsigned i = 0; i < ny; i++) {
+			sy[i] = y[xorshift64(&seed) % ny];
+		}
+		mx = median(sx, nx);
+		d[b] = mx ? median(sy, ny) / mx - 1 : 0;
+	}
+	qsort(d, BOOT_ROUNDS, sizeof(double), cmp_double);
+	*lo = d[(unsigned)(BOOT_ROUNDS * ALPHA / 2)];
+	*hi = d[(unsigned)(BOOT_ROUNDS * (1 - ALPHA / 2)) - 1];
+}
+
+/*
+ * compare_metric: report the delta of the metric (lower is better) and
+ * return true if it is a significant regression.
+ */
+static bool
+compare_metric(const char *name, const char *metric, const double *x,
+    unsigned nx, const double *y, unsigned ny)
+{
+	const double mx = median(x, nx), my = median(y, ny);
+	const double delta = mx ? my / mx - 1 : 0;
+	const char *verdict = "";
+	double lo, hi, p;
+
+	if (nx < 2 || ny < 2) {
+		printf("%-16s %-7s %10.2f %10.2f %+7.1f%%  (too few samples)\n",
+		    name, metric, mx, my, delta * 100);
+		return false;
+	}
+	p = mann_whitney(x, nx, y, ny);
+	bootstrap_ci(x, nx, y, ny, &lo, &hi);
+	if (p < ALPHA && (lo > 0 || hi < 0)) {
+		verdict = delta > 0 ? "REGRESSION" : "improved";
+	}
+	printf("%-16s %-7s %10.2f %10.2f %+7.1f%% [%+6.1f%%, %+6.1f%%] "
+	    "%6.4f %s\n", name, metric, mx, my, delta * 100,
+	    lo * 100, hi * 100, p, verdict);
+	return delta > 0 && *verdict;
+}
+
+static unsigned
+compare(const bench_res_t *base, unsigned nbase, const bench_res_t *res,
+    unsigned nres)
+{
+	unsigned nregress = 0;
+
+	printf("\n%-16s %-7s %10s %10s %8s %18s %6s\n", "scenario", "metric",
+	    "base", "new", "delta", "95% CI", "p");
+	for (unsigned i = 0; i < nres; i++) {
+		const bench_res_t *r = &res[i], *b = NULL;
+
+		for (unsigned j = 0; j < nbase; j++) {
+			if (strcmp(base[j].name, r->name) == 0) {
+				b = &base[j];
+				break;
+			}
+		}
+		if (b == NULL) {
+			printf("%-16s (no base results)\n", r->name);
+			continue;
+		}
+		nregress += compare_metric(r->name, "ns/op",
+		    b->nsop, b->n, r->nsop, r->n);
+		nregress += compare_metric(r->name, "p99", b->p99, b->n,
+		    r->p99, r->n);
+	}
+	return nregress;
+}
+
+static void
+usage(const char *prog)
+{
+	fprintf(stderr,
+	    "Usage:\t%s [-n reps] [-d dir -r rev [-b base-rev]]\n"
+	    "\t-n\tnumber of repetitions (default: 1)\n"
+	    "\t-d\tdirectory of the results\n"
+	    "\t-r\trevision of the results to store\n"
+	    "\t-b\tbase revision to compare against\n", prog);
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+	static bench_res_t res[NBENCH], base[NBENCH];
+	const char *dir = NULL, *rev = NULL, *baserev = NULL;
+	unsigned reps = 1, nregress = 0;
+	char cpu[128], path[512];
+	int ch;
+
+	while ((ch = getopt(argc, argv, "b:d:n:r:")) != -1) {
+		switch (ch) {
+		case 'b':
+			baserev = optarg;
+			break;
+		case 'd':
+			dir = optarg;
+			break;
+		case 'n':
+			reps = atoi(optarg);
+			break;
+		case 'r':
+			rev = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (reps == 0 || reps > MAXREPS || (dir == NULL) != (rev == NULL) ||
+	    (baserev && dir == NULL)) {
+		usage(argv[0]);
+	}
+	cpu_model(cpu, sizeof(cpu));
+
+	setup_ring();
+	for (unsigned rep = 0; rep < reps; rep++) {
+		for (unsigned i = 0; i < NBENCH; i++) {
+			const bench_t *b = &benchmarks[i];
+			const unsigned nbatches = b->nops / BATCH;
+			bench_res_t *r = &res[i];
+			uint64_t start, elapsed;
+
+			start = now_nsec();
+			sink += b->func(b->len, b->crc, lat);
+			elapsed = now_nsec() - start;
+
+			qsort(lat, nbatches, sizeof(uint64_t), cmp_u64);
+			snprintf(r->name, sizeof(r->name), "%s", b->name);
+			r->nsop[r->n] = (double)elapsed / b->nops;
+			r->p99[r->n] = lat[nbatches * 99 / 100];
+			r->n++;
+		}
+	}
+	free(ringbuf);
+
+	/* The medians over the repetitions. */
+	for (unsigned i = 0; i < NBENCH; i++) {
+		const double nsop = median(res[i].nsop, reps);
+
+		printf("%-16s %8.2f ns/op %12.0f ops/s %8.0f ns p99/batch\n",
+		    res[i].name, nsop, 1000000000 / nsop,
+		    median(res[i].p99, reps));
+	}
+
+	if (dir) {
+		if (mkdir(dir, 0755) == -1 && errno != EEXIST) {
+			err(EXIT_FAILURE, "%s", dir);
+		}
+		result_path(path, sizeof(path), dir, rev, cpu);
+		results_store(path, rev, cpu, res, NBENCH);
+		printf("\nresults: %s\n", path);
+	}
+	if (baserev) {
+		const unsigned nbase = (result_path(path, sizeof(path), dir,
+		    baserev, cpu), results_load(path, base, NBENCH));
+
+		printf("base: %s (%s)\n", path, cpu);
+		nregress = compare(base, nbase, res, NBENCH);
+	}
+	return nregress ? EXIT_FAILURE : EXIT_SUCCESS;
+}
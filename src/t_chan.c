@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "ringbuf_chan.h"
+
+#define	NCLIENTS	3
+#define	NCALLS		10000
+
+static ringbuf_chan_t *	chan;
+static volatile bool	stop;
+
+/*
+ * Echo the request incrementing every byte.
+ */
+static size_t
+echo_handler(void *arg, const void *req, size_t len, void *resp, size_t max)
+{
+	const unsigned char *src = req;
+	unsigned char *dst = resp;
+
+	assert(len <= max);
+	for (size_t i = 0; i < len; i++) {
+		dst[i] = src[i] + 1;
+	}
+	(*(unsigned *)arg)++;
+	return len;
+}
+
+static void
+test_basic(void)
+{
+	ringbuf_chan_t *ch = malloc(ringbuf_chan_get_size(1, 64, 8));
+	unsigned char buf[100] = { 0 };
+	unsigned nserved = 0;
+	int ret;
+
+	/* Invalid parameters. */
+	ret = ringbuf_chan_setup(ch, 0, 64, 8);
+	assert(ret == -1);
+
+	/* Nothing pending. */
+	ret = ringbuf_chan_setup(ch, 1, 64, 8);
+	assert(ret == 0);
+	ret = ringbuf_chan_serve(ch, echo_handler, &nserved);
+	assert(ret == 0 && nserved == 0);
+
+	/* The request cannot fit the ring. */
+	ret = ringbuf_chan_call(ch, 0, buf, 48, NULL, 0, RINGBUF_CHAN_SPIN);
+	assert(ret == -1 && errno == EINVAL);
+	ret = ringbuf_chan_call(ch, 0, buf, 100, NULL, 0, RINGBUF_CHAN_SPIN);
+	assert(ret == -1 && errno == EINVAL);
+	ret = ringbuf_chan_serve(ch, echo_handler, &nserved);
+	assert(ret == 0 && nserved == 0);
+	free(ch);
+}
+
+static void *
+server(void *arg)
+{
+	unsigned nserved = 0;
+
+	(void)arg;
+	while (!stop) {
+		if (ringbuf_chan_serve(chan, echo_handler, &nserved) == 0) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void *
+client(void *arg)
+{
+	const unsigned id = (uintptr_t)arg;
+	const unsigned flags = (id % 2) ?
+	    RINGBUF_CHAN_SLEEP : RINGBUF_CHAN_SPIN;
+	const unsigned ncalls = (flags & RINGBUF_CHAN_SLEEP) ?
+	    NCALLS : NCALLS / 100;
+
+	for (unsigned i = 0; i < ncalls; i++) {
+		unsigned char req[64], resp[64];
+		const size_t len = (i % sizeof(req)) + 1;
+		ssize_t ret;
+
+		memset(req, (int)(id + i), len);
+		while ((ret = ringbuf_chan_call(chan, id, req, len,
+		    resp, sizeof(resp), flags)) == -1) {
+			sched_yield();
+		}
+		assert((size_t)ret == len);
+		for (size_t j = 0; j < len; j++) {
+			assert(resp[j] == (unsigned char)(req[j] + 1));
+		}
+
+		/* Truncated response. */
+		if (i % 100 == 0) {
+			memset(resp, 0, sizeof(resp));
+			while ((ret = ringbuf_chan_call(chan, id, req, len,
+			    resp, 1, flags)) == -1) {
+				sched_yield();
+			}
+			assert((size_t)ret == len);
+			assert(resp[0] == (unsigned char)(req[0] + 1));
+			for (size_t j = 1; j < sizeof(resp); j++) {
+				assert(resp[j] == 0);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t srv, thr[NCLIENTS];
+
+	stop = false;
+	pthread_create(&srv, NULL, server, NULL);
+	for (unsigned i = 0; i < NCLIENTS; i++) {
+		pthread_create(&thr[i], NULL, client, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < NCLIENTS; i++) {
+		pthread_join(thr[i], NULL);
+	}
+	stop = true;
+	pthread_join(srv, NULL);
+}
+
+int
+main(void)
+{
+	const size_t size = ringbuf_chan_get_size(NCLIENTS, 1024, 64);
+	int ret;
+
+	chan = malloc(size);
+	assert(chan != NULL);
+	ret = ringbuf_chan_setup(chan, NCLIENTS, 1024, 64);
+	assert(ret == 0); (void)ret;
+
+	test_basic();
+	test_concurrent();
+	free(chan);
+	puts("ok");
+	return 0;
+}
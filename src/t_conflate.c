@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_conflate.h"
+
+#define	MAX_WORKERS	2
+#define	NKEYS		64
+#define	NUPDATES	20000
+
+static uint64_t		rbuf[512];
+static ringbuf_t *	ring;
+static ringbuf_conflate_t *conf;
+
+static void
+setup(unsigned nslots)
+{
+	size_t size;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	ring = malloc(size);
+	ringbuf_setup(ring, MAX_WORKERS, sizeof(rbuf));
+	conf = malloc(ringbuf_conflate_get_size(nslots));
+	assert(ringbuf_conflate_setup(conf, nslots) == 0);
+}
+
+static void
+teardown(void)
+{
+	free(conf);
+	free(ring);
+}
+
+static uint64_t
+rec_value(ringbuf_frame_t *f)
+{
+	uint64_t val;
+
+	memcpy(&val, ringbuf_frame_data(f), sizeof(val));
+	return val;
+}
+
+static void
+test_basic(void)
+{
+	uint64_t pad[2] = { 0 };
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	uint64_t val;
+
+	setup(16);
+	assert(ringbuf_conflate_setup(conf, 12) == -1);
+	w = ringbuf_register(ring, 0);
+	ringbuf_frame_iter_init(&it, ring, rbuf);
+	ringbuf_frame_iter_setconflate(&it, conf);
+
+	/* Updated in place while pending. */
+	val = 1;
+	assert(ringbuf_conflate_publish(conf, ring, w, rbuf, 7, &val, 8) == 0);
+	val = 2;
+	assert(ringbuf_conflate_publish(conf, ring, w, rbuf, 7, &val, 8) == 1);
+	val = 3;
+	assert(ringbuf_conflate_publish(conf, ring, w, rbuf, 9, &val, 8) == 0);
+
+	assert(ringbuf_frame_consume(&it, 0));
+	f = ringbuf_frame_peek(&it);
+	assert(ringbuf_frame_key(f) == 7 && rec_value(f) == 2);
+	assert(ringbuf_frame_next(&it) == f);
+
+	/* Claimed: a new value takes a new record. */
+	val = 4;
+	assert(ringbuf_conflate_publish(conf, ring, w, rbuf, 7, &val, 8) == 0);
+	f = ringbuf_frame_next(&it);
+	assert(ringbuf_frame_key(f) == 9 && rec_value(f) == 3);
+	assert(ringbuf_frame_next(&it) == NULL);
+	ringbuf_frame_release(&it);
+
+	/* Superseded by a record of a different length. */
+	memcpy(pad, &val, 8);
+	assert(ringbuf_conflate_publish(conf, ring, w, rbuf, 7, pad, 16) == 0);
+	assert(ringbuf_frame_consume(&it, 0));
+	f = ringbuf_frame_next(&it);
+	assert(ringbuf_frame_key(f) == 7 && f->len == 16);
+	assert(rec_value(f) == 4);
+	assert(ringbuf_frame_next(&it) == NULL);
+	assert(it.nconflated == 1);
+	ringbuf_frame_release(&it);
+
+	/* The ring does not fill with the updates of the same key. */
+	for (val = 0; val < 1000; val++) {
+		assert(ringbuf_conflate_publish(conf, ring, w,
+		    rbuf, 1, &val, 8) != -1);
+	}
+	assert(ringbuf_frame_consume(&it, 0));
+	f = ringbuf_frame_next(&it);
+	assert(ringbuf_frame_key(f) == 1 && rec_value(f) == 999);
+	assert(ringbuf_frame_next(&it) == NULL);
+	ringbuf_frame_release(&it);
+	teardown();
+}
+
+static void *
+producer(void *arg)
+{
+	const unsigned id = (uintptr_t)arg;
+	ringbuf_worker_t *w = ringbuf_register(ring, id);
+
+	/* Each producer updates its own half of the keys. */
+	for (uint64_t val = 1; val <= NUPDATES; val++) {
+		const uint64_t key = id * (NKEYS / 2) + val % (NKEYS / 2);
+
+		while (ringbuf_conflate_publish(conf, ring, w,
+		    rbuf, key, &val, 8) == -1) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(unsigned nslots)
+{
+	uint64_t last[NKEYS] = { 0 }, nrecs = 0;
+	ringbuf_frame_iter_t it;
+	pthread_t thr[MAX_WORKERS];
+	unsigned nfinal = 0;
+
+	setup(nslots);
+	ringbuf_frame_iter_init(&it, ring, rbuf);
+	ringbuf_frame_iter_setconflate(&it, conf);
+	for (unsigned i = 0; i < MAX_WORKERS; i++) {
+		pthread_create(&thr[i], NULL, producer, (void *)(uintptr_t)i);
+	}
+
+	/* The values of each key never go back; the last one arrives. */
+	while (nfinal < NKEYS) {
+		ringbuf_frame_t *f;
+
+		if (!ringbuf_frame_consume(&it, 0)) {
+			sched_yield();
+			continue;
+		}
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			const uint64_t key = ringbuf_frame_key(f);
+			const uint64_t val = rec_value(f);
+
+			assert(key < NKEYS && val > last[key]);
+			last[key] = val;
+			nfinal += val > NUPDATES - NKEYS / 2;
+			nrecs++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	for (unsigned i = 0; i < MAX_WORKERS; i++) {
+		pthread_join(thr[i], NULL);
+	}
+	assert(nrecs + it.nconflated <= MAX_WORKERS * NUPDATES);
+	teardown();
+}
+
+int
+main(void)
+{
+	test_basic();
+	test_concurrent(NKEYS * 2);
+	test_concurrent(NKEYS / 4);
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_exec.h"
+#include "utils.h"
+
+#define	NWORKERS	2
+#define	NSUBMITTERS	2
+#define	RING_SIZE	4096
+#define	NTASKS		50000
+#define	BATCH		8
+
+typedef struct {
+	volatile uint64_t *	sum;
+	uint64_t		val;
+	uint8_t			data[80];	/* pattern derived from 'val' */
+} closure_t;
+
+static ringbuf_exec_t *	exec;
+static volatile uint64_t sum;
+
+static void
+add_task(void *arg)
+{
+	closure_t *c = arg;
+
+	/* The state is in place, aligned and intact. */
+	assert(((uintptr_t)c & 7) == 0);
+	for (unsigned i = 0; i < sizeof(c->data); i++) {
+		assert(c->data[i] == (uint8_t)(c->val + i));
+	}
+	atomic_fetch_add_explicit(c->sum, c->val, memory_order_relaxed);
+}
+
+static void
+noop_task(void *arg)
+{
+	(void)arg;
+}
+
+static void
+make_closure(closure_t *c, uint64_t val)
+{
+	c->sum = &sum;
+	c->val = val;
+	for (unsigned i = 0; i < sizeof(c->data); i++) {
+		c->data[i] = (uint8_t)(val + i);
+	}
+}
+
+static void
+test_inline(void)
+{
+	closure_t c[BATCH];
+	ringbuf_task_t tasks[BATCH];
+
+	exec = ringbuf_exec_create(1, 1, RING_SIZE);
+	assert(exec != NULL);
+	sum = 0;
+
+	/* Nothing to run. */
+	assert(ringbuf_exec_run(exec, 0) == 0);
+
+	make_closure(&c[0], 5);
+	assert(ringbuf_exec_submit(exec, 0, add_task, &c[0], sizeof(c[0])) == 0);
+	for (unsigned i = 0; i < BATCH; i++) {
+		make_closure(&c[i], i + 1);
+		tasks[i].fn = add_task;
+		tasks[i].arg = &c[i];
+		tasks[i].len = sizeof(c[i]);
+	}
+	assert(ringbuf_exec_submit_batch(exec, 0, tasks, BATCH) == 0);
+	assert(ringbuf_exec_run(exec, 0) == 1 + BATCH);
+	assert(sum == 5 + BATCH * (BATCH + 1) / 2);
+
+	/* The ring is full. */
+	while (ringbuf_exec_submit(exec, 0, add_task, &c[0], sizeof(c[0])) == 0) {
+		continue;
+	}
+	assert(errno == EAGAIN);
+	while (ringbuf_exec_run(exec, 0)) {
+		continue;
+	}
+
+	/* The state is too long or the batch takes the whole ring. */
+	{
+		static uint8_t state[RINGBUF_EXEC_MAXARG + 1];
+		ringbuf_task_t big[RING_SIZE / 128];
+
+		assert(ringbuf_exec_submit(exec, 0, noop_task, state,
+		    sizeof(state)) == -1 && errno == EINVAL);
+		for (unsigned i = 0; i < RING_SIZE / 128; i++) {
+			big[i] = (ringbuf_task_t){ .fn = noop_task,
+			    .arg = state, .len = RINGBUF_EXEC_MAXARG };
+		}
+		assert(ringbuf_exec_submit_batch(exec, 0, big,
+		    RING_SIZE / 128) == -1 && errno == EINVAL);
+	}
+	ringbuf_exec_destroy(exec);
+}
+
+static void *
+worker(void *arg)
+{
+	ringbuf_exec_worker(exec, (uintptr_t)arg);
+	return NULL;
+}
+
+static void *
+submitter(void *arg)
+{
+	const unsigned id = (uintptr_t)arg;
+	ringbuf_task_t tasks[BATCH];
+	closure_t c[BATCH];
+
+	for (unsigned n = 0; n < NTASKS; n += BATCH) {
+		for (unsigned i = 0; i < BATCH; i++) {
+			make_closure(&c[i], n + i);
+			tasks[i].fn = add_task;
+			tasks[i].arg = &c[i];
+			tasks[i].len = sizeof(c[i]);
+		}
+		/* Alternate single and batch submissions. */
+		if ((n / BATCH) % 2) {
+			while (ringbuf_exec_submit_batch(exec, id,
+			    tasks, BATCH) == -1) {
+				sched_yield();
+			}
+			continue;
+		}
+		for (unsigned i = 0; i < BATCH; i++) {
+			while (ringbuf_exec_submit(exec, id, add_task,
+			    &c[i], sizeof(c[i])) == -1) {
+				sched_yield();
+			}
+		}
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	const uint64_t expected = (uint64_t)NSUBMITTERS *
+	    NTASKS * (NTASKS - 1) / 2;
+	pthread_t wthr[NWORKERS], sthr[NSUBMITTERS];
+	closure_t c;
+
+	exec = ringbuf_exec_create(NWORKERS, NSUBMITTERS, RING_SIZE);
+	assert(exec != NULL);
+	sum = 0;
+	for (unsigned i = 0; i < NWORKERS; i++) {
+		pthread_create(&wthr[i], NULL, worker, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < NSUBMITTERS; i++) {
+		pthread_create(&sthr[i], NULL, submitter, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < NSUBMITTERS; i++) {
+		pthread_join(sthr[i], NULL);
+	}
+	while (sum != expected) {
+		sched_yield();
+	}
+
+	/* The workers block when idle and wake up on a submission. */
+	usleep(50 * 1000);
+	make_closure(&c, 1);
+	assert(ringbuf_exec_submit(exec, 0, add_task, &c, sizeof(c)) == 0);
+	while (sum != expected + 1) {
+		sched_yield();
+	}
+
+	ringbuf_exec_stop(exec);
+	for (unsigned i = 0; i < NWORKERS; i++) {
+		pthread_join(wthr[i], NULL);
+	}
+	ringbuf_exec_destroy(exec);
+}
+
+int
+main(void)
+{
+	test_inline();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
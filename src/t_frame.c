@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "ringbuf_frame.h"
+#include "crc32c.h"
+
+#define	MAX_WORKERS	2
+
+static size_t		ringbuf_obj_size;
+
+static ringbuf_frame_t *
+frame_at_off(uint64_t *buf, size_t off)
+{
+	return (void *)((uint8_t *)buf + off);
+}
+
+static void
+produce_msg(ringbuf_t *r, ringbuf_worker_t *w, uint64_t *buf,
+    unsigned char val, size_t len, uint64_t deadline)
+{
+	const ringbuf_frame_opts_t opts = { .deadline = deadline };
+	ringbuf_frame_t *f;
+
+	f = ringbuf_frame_acquire(r, w, buf, len, &opts);
+	assert(f != NULL);
+	assert(ringbuf_frame_deadline(f) == deadline);
+	memset(ringbuf_frame_data(f), val, len);
+	ringbuf_frame_produce(r, w, f);
+}
+
+static void
+test_basic(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint64_t buf[32];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	size_t len;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+
+	/* Header plus payload, rounded up. */
+	assert(ringbuf_frame_size(1, NULL) == 16);
+	assert(ringbuf_frame_size(8, NULL) == 16);
+	assert(ringbuf_frame_size(8, &(ringbuf_frame_opts_t){ .deadline = 1 }) == 24);
+
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 0);
+
+	produce_msg(r, w, buf, 1, 3, 0);
+	produce_msg(r, w, buf, 2, 13, 0);
+
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 16 + 24);
+
+	f = ringbuf_frame_next(&it);
+	assert(f && f->len == 3);
+	assert(((unsigned char *)ringbuf_frame_data(f))[2] == 1);
+
+	/* Release the first record only. */
+	ringbuf_frame_release(&it);
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 24);
+
+	f = ringbuf_frame_next(&it);
+	assert(f && f->len == 13);
+	assert(((unsigned char *)ringbuf_frame_data(f))[12] == 2);
+	assert(ringbuf_frame_next(&it) == NULL);
+	ringbuf_frame_release(&it);
+
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 0);
+
+	ringbuf_unregister(r, w);
+	free(r);
+}
+
+static void
+test_deadline(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint64_t buf[64];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	size_t len;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+
+	/*
+	 * Two expired records at the front, then a live record, then
+	 * one expired and one without a deadline.
+	 */
+	produce_msg(r, w, buf, 1, 8, 100);
+	produce_msg(r, w, buf, 2, 8, 150);
+	produce_msg(r, w, buf, 3, 8, 500);
+	produce_msg(r, w, buf, 4, 8, 120);
+	produce_msg(r, w, buf, 5, 8, 0);
+
+	/* The expired front is released right away. */
+	len = ringbuf_frame_consume(&it, 200);
+	assert(len == 24 * 2 + 16);
+	assert(it.nexpired == 2);
+
+	f = ringbuf_frame_next(&it);
+	assert(f && ringbuf_frame_deadline(f) == 500);
+	f = ringbuf_frame_next(&it);
+	assert(f && ringbuf_frame_deadline(f) == 0);
+	assert(*(unsigned char *)ringbuf_frame_data(f) == 5);
+	assert(ringbuf_frame_next(&it) == NULL);
+	assert(it.nexpired == 3);
+	ringbuf_frame_release(&it);
+
+	/* Everything expired: nothing to consume, all released. */
+	produce_msg(r, w, buf, 6, 8, 300);
+	produce_msg(r, w, buf, 7, 8, 300);
+	len = ringbuf_frame_consume(&it, 300);
+	assert(len == 0);
+	assert(it.nexpired == 5);
+
+	/* Zero time disables the deadline checks. */
+	produce_msg(r, w, buf, 8, 8, 300);
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 24);
+	f = ringbuf_frame_next(&it);
+	assert(f && *(unsigned char *)ringbuf_frame_data(f) == 8);
+	ringbuf_frame_release(&it);
+
+	ringbuf_unregister(r, w);
+	free(r);
+}
+
+static void
+test_wraparound(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint64_t buf[16];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	unsigned next = 0, seen = 0;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+
+	/*
+	 * Variable length records over a small ring, verifying that
+	 * the records are always contiguous and in order.
+	 */
+	for (unsigned i = 0; i < 10000; i++) {
+		const size_t len = i % 37 + 1;
+		ringbuf_frame_t *f;
+
+		f = ringbuf_frame_acquire(r, w, buf, len, NULL);
+		if (f) {
+			memset(ringbuf_frame_data(f), next++ & 0xff, len);
+			ringbuf_frame_produce(r, w, f);
+		}
+		if (i % 3 == 0 && ringbuf_frame_consume(&it, 0)) {
+			while ((f = ringbuf_frame_next(&it)) != NULL) {
+				const unsigned char *p = ringbuf_frame_data(f);
+				assert(p[0] == (seen & 0xff));
+				assert(p[f->len - 1] == (seen & 0xff));
+				seen++;
+			}
+			ringbuf_frame_release(&it);
+		}
+	}
+	assert(seen > 0 && seen <= next);
+
+	ringbuf_unregister(r, w);
+	free(r);
+}
+
+static void
+test_frag(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint64_t buf[32];
+	ringbuf_frag_t fr[MAX_WORKERS];
+	unsigned char *msg[MAX_WORKERS];
+	unsigned nsent[MAX_WORKERS] = { 0 }, nrecv[MAX_WORKERS] = { 0 };
+	const size_t msglen = 5000;
+	ringbuf_frame_iter_t it;
+	ringbuf_reasm_t *ra;
+	bool pending[MAX_WORKERS] = { false };
+	int ret;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	ringbuf_frame_iter_init(&it, r, buf);
+	ra = ringbuf_reasm_create(MAX_WORKERS);
+	assert(ra != NULL);
+
+	/*
+	 * Two producers streaming messages (much larger than the ring)
+	 * with the interleaved chunks.
+	 */
+	for (unsigned i = 0; i < MAX_WORKERS; i++) {
+		ringbuf_worker_t *w = ringbuf_register(r, i);
+
+		ret = ringbuf_frag_init(&fr[i], r, w, buf, i, 40 + i * 16);
+		assert(ret == 0);
+		msg[i] = malloc(msglen);
+	}
+	while (nrecv[0] < 10 || nrecv[1] < 10) {
+		ringbuf_frame_t *f;
+
+		for (unsigned i = 0; i < MAX_WORKERS; i++) {
+			if (nsent[i] == 10) {
+				continue;
+			}
+			if (!pending[i]) {
+				const size_t len = msglen - nsent[i] * 100;
+
+				memset(msg[i], 'a' + nsent[i] + i, len);
+				ringbuf_frag_begin(&fr[i], msg[i], len);
+				pending[i] = true;
+			}
+			if (ringbuf_frag_write(&fr[i]) == 0) {
+				pending[i] = false;
+				nsent[i]++;
+			}
+		}
+		if (ringbuf_frame_consume(&it, 0) == 0) {
+			continue;
+		}
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			const unsigned src = f->src;
+			unsigned char *p;
+			size_t len;
+
+			assert(f->flags & RINGBUF_FRAME_FRAG);
+			if ((p = ringbuf_reasm_push(ra, f, &len)) == NULL) {
+				continue;
+			}
+			assert(len == msglen - nrecv[src] * 100);
+			assert(p[0] == 'a' + nrecv[src] + src);
+			assert(p[len - 1] == 'a' + nrecv[src] + src);
+			nrecv[src]++;
+		}
+		ringbuf_frame_release(&it);
+	}
+
+	for (unsigned i = 0; i < MAX_WORKERS; i++) {
+		free(msg[i]);
+	}
+	ringbuf_reasm_destroy(ra);
+	free(r);
+}
+
+static void
+test_frag_small(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint64_t buf[32];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frag_t fr;
+	ringbuf_reasm_t *ra;
+	ringbuf_frame_t *f;
+	void *p;
+	size_t len;
+	int ret;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+	ra = ringbuf_reasm_create(1);
+
+	/* The chunk record must fit the ring. */
+	ret = ringbuf_frag_init(&fr, r, w, buf, 0, 0);
+	assert(ret == -1 && errno == EINVAL);
+	ret = ringbuf_frag_init(&fr, r, w, buf, 0, sizeof(buf));
+	assert(ret == -1 && errno == EINVAL);
+
+	/* Fits in a single chunk: the payload is returned in place. */
+	ret = ringbuf_frag_init(&fr, r, w, buf, 0, 64);
+	assert(ret == 0);
+	ringbuf_frag_begin(&fr, "hello", 5);
+	ret = ringbuf_frag_write(&fr);
+	assert(ret == 0);
+
+	/* Empty message. */
+	ringbuf_frag_begin(&fr, NULL, 0);
+	ret = ringbuf_frag_write(&fr);
+	assert(ret == 0);
+
+	ringbuf_frame_consume(&it, 0);
+	f = ringbuf_frame_next(&it);
+	assert(f->flags & RINGBUF_FRAME_FIRST);
+	assert(f->flags & RINGBUF_FRAME_LAST);
+	p = ringbuf_reasm_push(ra, f, &len);
+	assert(p == ringbuf_frame_data(f) && len == 5);
+	assert(memcmp(p, "hello", 5) == 0);
+
+	f = ringbuf_frame_next(&it);
+	p = ringbuf_reasm_push(ra, f, &len);
+	assert(p != NULL && len == 0);
+	ringbuf_frame_release(&it);
+
+	ringbuf_reasm_destroy(ra);
+	free(r);
+}
+
+static void
+test_blob(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	ringbuf_pool_t *pool = malloc(ringbuf_pool_get_size(2, 1000));
+	uint64_t buf[16];
+	ringbuf_frame_opts_t opts = { .indirect = 64 };
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	unsigned char *p;
+	size_t len;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	ringbuf_pool_setup(pool, 2, 1000);
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+	ringbuf_frame_iter_setpool(&it, pool);
+	opts.pool = pool;
+
+	/* Large records take 16 bytes; small ones stay inline. */
+	assert(ringbuf_frame_size(1000, &opts) == 16);
+	assert(ringbuf_frame_size(10, &opts) == 24);
+
+	f = ringbuf_frame_acquire(r, w, buf, 1000, &opts);
+	assert(f != NULL && f->len == 1000);
+	memset(ringbuf_frame_payload(f, pool), 7, 1000);
+	ringbuf_frame_produce(r, w, f);
+
+	f = ringbuf_frame_acquire(r, w, buf, 10, &opts);
+	assert(f != NULL);
+	assert(ringbuf_frame_payload(f, pool) == ringbuf_frame_data(f));
+	memset(ringbuf_frame_payload(f, pool), 8, 10);
+	ringbuf_frame_produce(r, w, f);
+
+	f = ringbuf_frame_acquire(r, w, buf, 500, &opts);
+	assert(f != NULL);
+	ringbuf_frame_produce(r, w, f);
+
+	/* The pool is exhausted. */
+	f = ringbuf_frame_acquire(r, w, buf, 500, &opts);
+	assert(f == NULL);
+
+	/* Larger than the pool block (rounded up to 1024) or the ring. */
+	f = ringbuf_frame_acquire(r, w, buf, 1025, &opts);
+	assert(f == NULL && errno == EMSGSIZE);
+	f = ringbuf_frame_acquire(r, w, buf, sizeof(buf), NULL);
+	assert(f == NULL && errno == EMSGSIZE);
+
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 16 + 24 + 16);
+
+	f = ringbuf_frame_next(&it);
+	p = ringbuf_frame_payload(f, pool);
+	assert(f->len == 1000 && p[0] == 7 && p[999] == 7);
+	f = ringbuf_frame_next(&it);
+	p = ringbuf_frame_payload(f, pool);
+	assert(f->len == 10 && p[0] == 8 && p[9] == 8);
+	f = ringbuf_frame_next(&it);
+	assert(f->len == 500);
+	ringbuf_frame_release(&it);
+
+	/* Released records returned the blocks. */
+	for (unsigned i = 0; i < 2; i++) {
+		f = ringbuf_frame_acquire(r, w, buf, 100, &opts);
+		assert(f != NULL);
+		ringbuf_frame_produce(r, w, f);
+	}
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 32);
+	while (ringbuf_frame_next(&it) != NULL)
+		;
+	ringbuf_frame_release(&it);
+
+	/*
+	 * The block index of a corrupt record is not trusted: the block
+	 * is not returned on release, while the valid one is.
+	 */
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+	ringbuf_frame_iter_setpool(&it, pool);
+	opts.crc = true;
+	for (unsigned i = 0; i < 2; i++) {
+		f = ringbuf_frame_acquire(r, w, buf, 100, &opts);
+		assert(f != NULL);
+		ringbuf_frame_produce(r, w, f);
+	}
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 2 * 24);
+	buf[(24 + 8) / 8] = UINT32_MAX;	/* the block index field */
+	f = ringbuf_frame_next(&it);
+	assert(f != NULL && f->len == 100);
+	assert(ringbuf_frame_next(&it) == NULL);
+	assert(it.ncorrupt == 1);
+	ringbuf_frame_release(&it);
+
+	f = ringbuf_frame_acquire(r, w, buf, 100, &opts);
+	assert(f != NULL);
+	assert(ringbuf_frame_acquire(r, w, buf, 100, &opts) == NULL);
+	ringbuf_frame_produce(r, w, f);
+
+	free(pool);
+	free(r);
+}
+
+static void
+test_index(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint64_t buf[64];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	uint32_t offs[8];
+	size_t len, n;
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+
+	/* Mixed sizes, one expired record and the padding. */
+	produce_msg(r, w, buf, 1, 1, 0);
+	produce_msg(r, w, buf, 2, 20, 0);
+	produce_msg(r, w, buf, 3, 8, 100);
+	produce_msg(r, w, buf, 4, 8, 300);
+	ringbuf_frame_pad(&buf[ringbuf_acquire(r, w, 16) / 8], 16);
+	ringbuf_produce(r, w);
+	produce_msg(r, w, buf, 5, 4, 0);
+
+	len = ringbuf_frame_consume(&it, 200);
+	assert(len == 16 + 32 + 24 + 24 + 16 + 16);
+
+	/* In two batches. */
+	n = ringbuf_frame_index(&it, offs, 2);
+	assert(n == 2 && offs[0] == 0 && offs[1] == 16);
+	n = ringbuf_frame_index(&it, offs, 8);
+	assert(n == 2 && offs[0] == 72 && offs[1] == 112);
+	assert(it.nexpired == 1);
+	for (unsigned i = 0; i < n; i++) {
+		ringbuf_frame_t *f = frame_at_off(buf, offs[i]);
+		unsigned char *data = ringbuf_frame_data(f);
+
+		assert(data[0] == (i ? 5 : 4));
+	}
+	n = ringbuf_frame_index(&it, offs, 8);
+	assert(n == 0);
+
+	ringbuf_frame_release(&it);
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 0);
+
+	ringbuf_unregister(r, w);
+	free(r);
+}
+
+static uint32_t
+crc32c_ref(const uint8_t *p, size_t len)
+{
+	uint32_t crc = ~0U;
+
+	while (len--) {
+		crc ^= *p++;
+		for (unsigned i = 0; i < 8; i++) {
+			crc = (crc >> 1) ^ (0x82f63b78U & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+static void
+test_crc(void)
+{
+	const ringbuf_frame_opts_t opts = { .crc = true, .deadline = 500 };
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	uint8_t data[100], *p;
+	uint64_t buf[64];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	uint32_t crc;
+	size_t len;
+
+	/* Check value and the chaining. */
+	assert(ringbuf_crc32c(0, "123456789", 9) == 0xe3069283);
+	for (unsigned i = 0; i < sizeof(data); i++) {
+		data[i] = random();
+	}
+	for (unsigned i = 0; i < sizeof(data); i++) {
+		crc = ringbuf_crc32c(0, data, i);
+		crc = ringbuf_crc32c(crc, data + i, sizeof(data) - i);
+		assert(crc == crc32c_ref(data, sizeof(data)));
+	}
+
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+
+	/* Header, the deadline and the CRC fields. */
+	assert(ringbuf_frame_size(8, &opts) == 32);
+
+	for (unsigned i = 0; i < 3; i++) {
+		f = ringbuf_frame_acquire(r, w, buf, 20, &opts);
+		assert(f != NULL);
+		memset(ringbuf_frame_data(f), i, 20);
+		ringbuf_frame_produce(r, w, f);
+	}
+
+	/* Corrupt the payload of the second record. */
+	len = ringbuf_frame_consume(&it, 0);
+	assert(len == 3 * 48);
+	p = ringbuf_frame_data(frame_at_off(buf, 48));
+	p[19] ^= 1;
+
+	f = ringbuf_frame_next(&it);
+	assert(f && *(uint8_t *)ringbuf_frame_data(f) == 0);
+	f = ringbuf_frame_next(&it);
+	assert(f && *(uint8_t *)ringbuf_frame_data(f) == 2);
+	assert(ringbuf_frame_next(&it) == NULL);
+	assert(it.ncorrupt == 1);
+	ringbuf_frame_release(&it);
+
+	/*
+	 * Corrupt the length of an expired record at the front: it must
+	 * not be skipped by its length past the consumed range.
+	 */
+	f = ringbuf_frame_acquire(r, w, buf, 20, &opts);
+	assert(f != NULL);
+	ringbuf_frame_produce(r, w, f);
+	f->len = 4096;	/* after the CRC is set */
+	f = ringbuf_frame_acquire(r, w, buf, 20, &opts);
+	assert(f != NULL);
+	ringbuf_frame_produce(r, w, f);
+
+	len = ringbuf_frame_consume(&it, 1000);
+	assert(len == 2 * 48);
+	assert(ringbuf_frame_next(&it) == NULL);
+	assert(it.ncorrupt == 2 && it.nexpired == 0);
+	ringbuf_frame_release(&it);
+	assert(ringbuf_frame_consume(&it, 1000) == 0);
+
+	ringbuf_unregister(r, w);
+	free(r);
+}
+
+int
+main(void)
+{
+	ringbuf_get_sizes(MAX_WORKERS, &ringbuf_obj_size, NULL);
+	test_basic();
+	test_deadline();
+	test_wraparound();
+	test_frag();
+	test_frag_small();
+	test_blob();
+	test_index();
+	test_crc();
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "ringbuf_ingest.h"
+#include "ringbuf_frame.h"
+
+#define	MAX_WORKERS	1
+#define	MAXLEN		256
+
+static void
+test_ingest(void)
+{
+	ringbuf_t *r;
+	uint64_t buf[1024];
+	ringbuf_frame_iter_t it;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	size_t rsize;
+	unsigned seen = 0;
+	ssize_t n;
+	int sv[2];
+
+	ringbuf_get_sizes(MAX_WORKERS, &rsize, NULL);
+	r = malloc(rsize);
+	ringbuf_setup(r, MAX_WORKERS, sizeof(buf));
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+
+	if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) == -1) {
+		abort();
+	}
+
+	/* Nothing to receive. */
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 8, MAXLEN, MSG_DONTWAIT);
+	assert(n == 0);
+	assert(ringbuf_frame_consume(&it, 0) == 0);
+
+	/* Send 11 datagrams of a various size. */
+	for (unsigned i = 0; i < 11; i++) {
+		unsigned char dgram[MAXLEN];
+		const size_t len = (i * 23) % MAXLEN + 1;
+
+		memset(dgram, i, len);
+		if (send(sv[0], dgram, len, 0) != (ssize_t)len) {
+			abort();
+		}
+	}
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 8, MAXLEN, MSG_DONTWAIT);
+	assert(n == 8);
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 8, MAXLEN, MSG_DONTWAIT);
+	assert(n == 3);
+
+	/* The records come out in order, with the padding skipped. */
+	while (ringbuf_frame_consume(&it, 0)) {
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			const unsigned char *p = ringbuf_frame_data(f);
+
+			assert(f->len == (seen * 23) % MAXLEN + 1);
+			assert(p[0] == seen && p[f->len - 1] == seen);
+			seen++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	assert(seen == 11);
+
+	/* An empty poll does not touch the ring buffer. */
+	ringbuf_setup(r, MAX_WORKERS, 1024);
+	w = ringbuf_register(r, 0);
+	for (unsigned i = 0; i < 4; i++) {
+		n = ringbuf_ingest_dgram(r, w, buf, sv[1], 1, 600,
+		    MSG_DONTWAIT);
+		assert(n == 0);
+		assert(ringbuf_get_usage(r) == 0);
+	}
+
+	/* Ring buffer full: the datagram stays queued. */
+	if (send(sv[0], "x", 1, 0) != 1) {
+		abort();
+	}
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 1, 600, MSG_DONTWAIT);
+	assert(n == 1);
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 1, 600, MSG_DONTWAIT);
+	assert(n == 0);
+	if (send(sv[0], "y", 1, 0) != 1) {
+		abort();
+	}
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 1, 600, MSG_DONTWAIT);
+	assert(n == -1 && errno == ENOBUFS);
+
+	/* A record which can never fit. */
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], 1, 2000, MSG_DONTWAIT);
+	assert(n == -1 && errno == EINVAL);
+
+	/*
+	 * The batch is clamped to the ring; the truncated datagram is
+	 * flagged (MSG_TRUNC of the caller is ignored).
+	 */
+	ringbuf_setup(r, MAX_WORKERS, 1024);
+	w = ringbuf_register(r, 0);
+	ringbuf_frame_iter_init(&it, r, buf);
+	{
+		unsigned char dgram[300];
+
+		memset(dgram, 0xa5, sizeof(dgram));
+		if (send(sv[0], dgram, sizeof(dgram), 0) != sizeof(dgram)) {
+			abort();
+		}
+	}
+	n = ringbuf_ingest_dgram(r, w, buf, sv[1], RINGBUF_INGEST_MAX, 100,
+	    MSG_DONTWAIT | MSG_TRUNC);
+	assert(n == 2);
+	assert(ringbuf_frame_consume(&it, 0) > 0);
+	f = ringbuf_frame_next(&it);
+	assert(f && f->len == 1 && f->flags == 0);
+	assert(*(unsigned char *)ringbuf_frame_data(f) == 'y');
+	f = ringbuf_frame_next(&it);
+	assert(f && f->len == 100 && f->flags == RINGBUF_FRAME_TRUNC);
+	assert(((unsigned char *)ringbuf_frame_data(f))[99] == 0xa5);
+	assert(ringbuf_frame_next(&it) == NULL);
+	ringbuf_frame_release(&it);
+
+	close(sv[0]);
+	close(sv[1]);
+	free(r);
+}
+
+int
+main(void)
+{
+	test_ingest();
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ringbuf_merge.h"
+
+#define	NRINGS		3
+#define	MAX_WORKERS	1
+
+static size_t		ringbuf_obj_size;
+static ringbuf_t *	rings[NRINGS];
+static ringbuf_worker_t *workers[NRINGS];
+static uint64_t		bufs[NRINGS][64];
+
+static void
+setup_rings(void)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		rings[i] = malloc(ringbuf_obj_size);
+		ringbuf_setup(rings[i], MAX_WORKERS, sizeof(bufs[i]));
+		workers[i] = ringbuf_register(rings[i], 0);
+	}
+}
+
+static void
+destroy_rings(void)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		free(rings[i]);
+	}
+}
+
+static bool
+produce_msg(unsigned i, uint64_t tstamp)
+{
+	const ringbuf_frame_opts_t opts = { .tstamp = tstamp };
+	ringbuf_frame_t *f;
+
+	f = ringbuf_frame_acquire(rings[i], workers[i], bufs[i], 4, &opts);
+	if (f == NULL) {
+		return false;
+	}
+	assert(ringbuf_frame_tstamp(f) == tstamp);
+	memcpy(ringbuf_frame_data(f), &i, 4);
+	ringbuf_frame_produce(rings[i], workers[i], f);
+	return true;
+}
+
+static ringbuf_merge_t *
+merge_create(unsigned flags)
+{
+	ringbuf_merge_t *m = ringbuf_merge_create(NRINGS, flags);
+
+	assert(m != NULL);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_merge_add(m, i, rings[i], bufs[i]);
+	}
+	return m;
+}
+
+static void
+test_basic(void)
+{
+	static const uint64_t ts[NRINGS][3] = {
+		{ 1, 5, 9 }, { 2, 3, 4 }, { 6, 7, 8 },
+	};
+	ringbuf_merge_t *m;
+	ringbuf_frame_t *f;
+	unsigned ring;
+
+	setup_rings();
+	m = merge_create(0);
+
+	f = ringbuf_merge_next(m, &ring);
+	assert(f == NULL);
+
+	for (unsigned i = 0; i < NRINGS; i++) {
+		for (unsigned j = 0; j < 3; j++) {
+			produce_msg(i, ts[i][j]);
+		}
+	}
+	for (uint64_t t = 1; t <= 9; t++) {
+		unsigned val;
+
+		f = ringbuf_merge_next(m, &ring);
+		assert(f != NULL);
+		assert(ringbuf_frame_tstamp(f) == t);
+		memcpy(&val, ringbuf_frame_data(f), 4);
+		assert(val == ring);
+	}
+	f = ringbuf_merge_next(m, &ring);
+	assert(f == NULL);
+	ringbuf_merge_release(m);
+
+	/* Records produced after exhausting the range. */
+	produce_msg(1, 10);
+	f = ringbuf_merge_next(m, &ring);
+	assert(f && ring == 1 && ringbuf_frame_tstamp(f) == 10);
+	f = ringbuf_merge_next(m, &ring);
+	assert(f == NULL);
+	ringbuf_merge_release(m);
+
+	ringbuf_merge_destroy(m);
+	destroy_rings();
+}
+
+static void
+test_strict(void)
+{
+	ringbuf_merge_t *m;
+	ringbuf_frame_t *f;
+	uint64_t t = 0, last = 0;
+	unsigned ring, n = 0;
+
+	setup_rings();
+	m = merge_create(RINGBUF_MERGE_STRICT);
+
+	/* Any of the rings is empty: nothing is yielded. */
+	produce_msg(0, ++t);
+	produce_msg(1, ++t);
+	f = ringbuf_merge_next(m, &ring);
+	assert(f == NULL);
+
+	/*
+	 * Produce into random rings with the global clock; the merged
+	 * records must be in the time order, across the batches.
+	 */
+	for (unsigned i = 0; i < 100000; i++) {
+		unsigned batch = 0;
+
+		if (produce_msg(random() % NRINGS, t + 1)) {
+			t++;
+		}
+		if (random() % 4) {
+			continue;
+		}
+		while ((f = ringbuf_merge_next(m, &ring)) != NULL) {
+			const uint64_t ts = ringbuf_frame_tstamp(f);
+
+			assert(ts > last);
+			last = ts;
+			n++;
+
+			if (++batch == 8) {
+				break;
+			}
+		}
+		ringbuf_merge_release(m);
+	}
+	assert(n > 0);
+
+	ringbuf_merge_destroy(m);
+	destroy_rings();
+}
+
+int
+main(void)
+{
+	ringbuf_get_sizes(MAX_WORKERS, &ringbuf_obj_size, NULL);
+	test_basic();
+	test_strict();
+	puts("ok");
+	return 0;
+}
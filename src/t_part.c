@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_part.h"
+
+#define	NPARTS		4
+#define	MAX_WORKERS	1
+#define	BATCH		16
+#define	NRECS		100000
+
+static size_t		ringbuf_obj_size;
+static ringbuf_t *	rings[NPARTS];
+static ringbuf_worker_t *workers[NPARTS];
+static uint64_t		bufs[NPARTS][512];
+static ringbuf_part_t *	parts;
+
+/* The next expected value per partition, updated by its owner. */
+static uint32_t		expected[NPARTS];
+static volatile bool	done;
+
+static void
+setup(void)
+{
+	parts = ringbuf_part_create(NPARTS, BATCH);
+	assert(parts != NULL);
+	for (unsigned i = 0; i < NPARTS; i++) {
+		rings[i] = malloc(ringbuf_obj_size);
+		ringbuf_setup(rings[i], MAX_WORKERS, sizeof(bufs[i]));
+		workers[i] = ringbuf_register(rings[i], 0);
+		ringbuf_part_add(parts, i, rings[i], bufs[i]);
+		expected[i] = 0;
+	}
+}
+
+static void
+teardown(void)
+{
+	for (unsigned i = 0; i < NPARTS; i++) {
+		free(rings[i]);
+	}
+	ringbuf_part_destroy(parts);
+}
+
+static bool
+produce_msg(unsigned i, uint32_t val)
+{
+	ringbuf_frame_t *f;
+
+	f = ringbuf_frame_acquire(rings[i], workers[i], bufs[i], 4, NULL);
+	if (f == NULL) {
+		return false;
+	}
+	memcpy(ringbuf_frame_data(f), &val, 4);
+	ringbuf_frame_produce(rings[i], workers[i], f);
+	return true;
+}
+
+static void
+fifo_handler(void *arg, unsigned part, ringbuf_frame_t *f)
+{
+	uint32_t val;
+
+	(void)arg;
+	memcpy(&val, ringbuf_frame_data(f), 4);
+	assert(val == expected[part]);
+	expected[part]++;
+}
+
+static void
+nested_handler(void *arg, unsigned part, ringbuf_frame_t *f)
+{
+	/* The ring is owned: neither the home nor a stealer can enter. */
+	assert(ringbuf_part_drain(parts, part, fifo_handler, NULL) == 0);
+	fifo_handler(arg, part, f);
+}
+
+static void
+test_steal(void)
+{
+	setup();
+	assert(ringbuf_part_create(NPARTS, 0) == NULL);
+
+	/* Skew: all records in the first partition. */
+	for (unsigned i = 0; i < 100; i++) {
+		assert(produce_msg(0, i));
+	}
+	assert(ringbuf_part_drain(parts, 1, fifo_handler, NULL) == 0);
+
+	/* An idle consumer steals a batch, then the home continues. */
+	assert(ringbuf_part_steal(parts, 1, fifo_handler, NULL) == BATCH);
+	assert(ringbuf_part_nstolen(parts, 0) == BATCH);
+	assert(ringbuf_part_drain(parts, 0, nested_handler, NULL) == BATCH);
+	assert(ringbuf_part_steal(parts, 2, fifo_handler, NULL) == BATCH);
+	while (ringbuf_part_drain(parts, 0, fifo_handler, NULL)) {
+		continue;
+	}
+	assert(expected[0] == 100);
+	assert(ringbuf_part_nstolen(parts, 0) == 2 * BATCH);
+
+	/* Nothing to steal. */
+	assert(ringbuf_part_steal(parts, 1, fifo_handler, NULL) == 0);
+	teardown();
+}
+
+static void *
+producer(void *arg)
+{
+	uint32_t vals[NPARTS] = { 0 };
+
+	(void)arg;
+	for (unsigned n = 0; n < NRECS; n++) {
+		/* Most of the records go to the first partition. */
+		const unsigned i = (n % 8) ? 0 : (n / 8) % NPARTS;
+
+		while (!produce_msg(i, vals[i])) {
+			sched_yield();
+		}
+		vals[i]++;
+	}
+	return NULL;
+}
+
+static void *
+consumer(void *arg)
+{
+	const unsigned self = (uintptr_t)arg;
+	uintptr_t total = 0;
+
+	for (;;) {
+		const bool last = done;
+		unsigned n;
+
+		n = ringbuf_part_drain(parts, self, fifo_handler, NULL);
+		if (n == 0) {
+			n = ringbuf_part_steal(parts, self, fifo_handler, NULL);
+		}
+		if (n == 0) {
+			if (last) {
+				break;
+			}
+			sched_yield();
+		}
+		total += n;
+	}
+	return (void *)total;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t prod, cons[NPARTS];
+	uintptr_t total = 0;
+
+	setup();
+	done = false;
+	for (unsigned i = 0; i < NPARTS; i++) {
+		pthread_create(&cons[i], NULL, consumer, (void *)(uintptr_t)i);
+	}
+	pthread_create(&prod, NULL, producer, NULL);
+	pthread_join(prod, NULL);
+	done = true;
+	for (unsigned i = 0; i < NPARTS; i++) {
+		void *ret;
+
+		pthread_join(cons[i], &ret);
+		total += (uintptr_t)ret;
+	}
+	assert(total == NRECS);
+	teardown();
+}
+
+int
+main(void)
+{
+	ringbuf_get_sizes(MAX_WORKERS, &ringbuf_obj_size, NULL);
+	test_steal();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <assert.h>
+
+#include "ringbuf_frame.h"
+
+#define	MAX_WORKERS	2
+#define	RBUF_SIZE	1024
+#define	REC_SIZE	24	/* header, CRC and 8-byte payload */
+
+static size_t		ringbuf_obj_size, data_off, file_size;
+
+/*
+ * The ring buffer object followed by the data space, in a file.
+ */
+static ringbuf_t *
+map_file(int fd)
+{
+	void *p;
+
+	p = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	assert(p != MAP_FAILED);
+	return p;
+}
+
+static int
+create_file(void)
+{
+	char path[] = "/tmp/t_persist.XXXXXX";
+	int fd;
+
+	fd = mkstemp(path);
+	assert(fd != -1);
+	unlink(path);
+	assert(ftruncate(fd, file_size) == 0);
+	return fd;
+}
+
+static void *
+data_space(ringbuf_t *r)
+{
+	return (uint8_t *)r + data_off;
+}
+
+/*
+ * crash: drop the mapping without any cleanup and map the file again.
+ */
+static ringbuf_t *
+crash(ringbuf_t *r, int fd)
+{
+	munmap(r, file_size);
+	return map_file(fd);
+}
+
+static ringbuf_frame_t *
+acquire_rec(ringbuf_t *r, ringbuf_worker_t *w, uint64_t val)
+{
+	const ringbuf_frame_opts_t opts = { .crc = true };
+	ringbuf_frame_t *f;
+
+	f = ringbuf_frame_acquire(r, w, data_space(r), sizeof(val), &opts);
+	assert(f != NULL);
+	memcpy(ringbuf_frame_data(f), &val, sizeof(val));
+	return f;
+}
+
+static void
+produce_recs(ringbuf_t *r, ringbuf_worker_t *w, unsigned mode,
+    uint64_t first, unsigned n)
+{
+	for (unsigned i = 0; i < n; i++) {
+		ringbuf_frame_t *f = acquire_rec(r, w, first + i);
+		int ret;
+
+		ret = ringbuf_frame_produce_durable(r, w, f, mode);
+		assert(ret == 0);
+	}
+}
+
+/*
+ * consume_recs: consume up to 'n' records, checking the values, and
+ * release them.  Returns the number of records consumed.
+ */
+static unsigned
+consume_recs(ringbuf_t *r, unsigned mode, uint64_t first, unsigned n)
+{
+	ringbuf_frame_iter_t it;
+	unsigned count = 0;
+
+	ringbuf_frame_iter_init(&it, r, data_space(r));
+	ringbuf_frame_iter_setpersist(&it, mode);
+	while (count < n && ringbuf_frame_consume(&it, 0)) {
+		ringbuf_frame_t *f;
+
+		while (count < n && (f = ringbuf_frame_next(&it)) != NULL) {
+			uint64_t val;
+
+			memcpy(&val, ringbuf_frame_data(f), sizeof(val));
+			assert(val == first + count);
+			count++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	assert(it.ncorrupt == 0);
+	return count;
+}
+
+static size_t
+bogus_scan(void *arg, size_t off, size_t len)
+{
+	(void)off;
+	return len + *(size_t *)arg;
+}
+
+/*
+ * The lengths returned by the scan function are checked.
+ */
+static void
+test_recover_bogus(void)
+{
+	const int fd = create_file();
+	ringbuf_t *r = map_file(fd);
+	size_t extra;
+
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	extra = 1;
+	assert(ringbuf_recover(r, bogus_scan, &extra) == -1);
+	assert(errno == EINVAL);
+
+	/* The whole space, but nothing was consumed. */
+	extra = 0;
+	assert(ringbuf_recover(r, bogus_scan, &extra) == -1);
+	assert(errno == EINVAL);
+
+	munmap(r, file_size);
+	close(fd);
+}
+
+static void
+test_recover(unsigned mode)
+{
+	ringbuf_worker_t *w0, *w1;
+	ringbuf_frame_t *f;
+	ringbuf_t *r;
+	ssize_t len;
+	int fd;
+
+	fd = create_file();
+	r = map_file(fd);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	w0 = ringbuf_register(r, 0);
+	w1 = ringbuf_register(r, 1);
+
+	/* Ten records, four of them consumed. */
+	produce_recs(r, w0, mode, 0, 10);
+	assert(consume_recs(r, mode, 0, 4) == 4);
+
+	/*
+	 * The second worker crashes before producing its record, but
+	 * the first one produces two more after it.
+	 */
+	f = acquire_rec(r, w1, 100);
+	produce_recs(r, w0, mode, 10, 2);
+	assert(consume_recs(r, mode, 4, 100) == 6);
+
+	/*
+	 * The records after the incomplete one were never visible to
+	 * the consumer and they are not recovered either.
+	 */
+	r = crash(r, fd);
+	len = ringbuf_frame_recover(r, data_space(r), mode);
+	assert(len == 0);
+	munmap(r, file_size);
+	close(fd);
+
+	/* Again, but crash before consuming. */
+	fd = create_file();
+	r = map_file(fd);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	w0 = ringbuf_register(r, 0);
+	w1 = ringbuf_register(r, 1);
+
+	produce_recs(r, w0, mode, 0, 10);
+	assert(consume_recs(r, mode, 0, 4) == 4);
+	f = acquire_rec(r, w1, 100);
+	assert(f != NULL);
+	produce_recs(r, w0, mode, 10, 2);
+
+	r = crash(r, fd);
+	len = ringbuf_frame_recover(r, data_space(r), mode);
+	assert(len == 6 * REC_SIZE);
+
+	/* The space of the incomplete record is reused. */
+	w0 = ringbuf_register(r, 0);
+	produce_recs(r, w0, mode, 10, 1);
+	assert(consume_recs(r, mode, 4, 100) == 7);
+	assert(ringbuf_get_usage(r) == 0);
+
+	/* Nothing to recover once consumed. */
+	r = crash(r, fd);
+	assert(ringbuf_frame_recover(r, data_space(r), mode) == 0);
+
+	munmap(r, file_size);
+	close(fd);
+}
+
+static void
+test_recover_wrap(unsigned mode)
+{
+	ringbuf_worker_t *w;
+	ringbuf_t *r;
+	ssize_t len;
+	int fd;
+
+	fd = create_file();
+	r = map_file(fd);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	w = ringbuf_register(r, 0);
+
+	/* Fill most of the space and consume. */
+	produce_recs(r, w, mode, 0, 40);
+	assert(consume_recs(r, mode, 0, 40) == 40);
+
+	/*
+	 * Two records fit at the end (up to the offset 1008), the other
+	 * three wrap around; the stale records of the first lap follow.
+	 */
+	produce_recs(r, w, mode, 40, 5);
+
+	r = crash(r, fd);
+	len = ringbuf_frame_recover(r, data_space(r), mode);
+	assert(len == 5 * REC_SIZE);
+	assert(consume_recs(r, mode, 40, 100) == 5);
+
+	r = crash(r, fd);
+	assert(ringbuf_frame_recover(r, data_space(r), mode) == 0);
+
+	munmap(r, file_size);
+	close(fd);
+}
+
+int
+main(void)
+{
+	const unsigned modes[] = {
+		RINGBUF_PERSIST_MSYNC,
+#if defined(__x86_64__)
+		RINGBUF_PERSIST_FLUSH,
+#endif
+	};
+
+	ringbuf_get_sizes(MAX_WORKERS, &ringbuf_obj_size, NULL);
+	data_off = (ringbuf_obj_size + 63) & ~(size_t)63;
+	file_size = data_off + RBUF_SIZE;
+
+	for (unsigned i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+		test_recover(modes[i]);
+		test_recover_wrap(modes[i]);
+	}
+	test_recover_bogus();
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_pipe.h"
+
+#define	MAX_WORKERS	1
+#define	NSTAGES		3
+#define	RBUF_SIZE	1000
+#define	NRECS		100000
+
+typedef struct {
+	uint64_t	seq;
+	uint64_t	acc;
+	uint64_t	stage;
+} rec_t;
+
+static uint8_t		rbuf[RBUF_SIZE];
+static ringbuf_t *	ring;
+static ringbuf_worker_t *worker;
+static ringbuf_pipe_t *	pl;
+
+static void
+setup(unsigned nstages)
+{
+	size_t size;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	ring = malloc(size);
+	ringbuf_setup(ring, MAX_WORKERS, RBUF_SIZE);
+	worker = ringbuf_register(ring, 0);
+	pl = ringbuf_pipe_create(ring, nstages);
+	assert(pl != NULL);
+}
+
+static void
+teardown(void)
+{
+	ringbuf_pipe_destroy(pl);
+	free(ring);
+}
+
+static bool
+produce_rec(uint64_t seq)
+{
+	const rec_t r = { .seq = seq };
+	ssize_t off;
+
+	if ((off = ringbuf_acquire(ring, worker, sizeof(rec_t))) == -1) {
+		return false;
+	}
+	memcpy(&rbuf[off], &r, sizeof(rec_t));
+	ringbuf_produce(ring, worker);
+	return true;
+}
+
+/*
+ * process: run the given stage over its range: decode, enrich and,
+ * in the last stage, verify the records.  Returns the number of records.
+ */
+static unsigned
+process(unsigned i, uint64_t *next)
+{
+	size_t off, len;
+	unsigned n = 0;
+
+	len = ringbuf_pipe_get(pl, i, &off);
+	for (size_t o = off; o < off + len; o += sizeof(rec_t)) {
+		rec_t *r = (rec_t *)&rbuf[o];
+
+		assert(r->stage == i);
+		switch (i) {
+		case 0:
+			r->acc = r->seq * 2;
+			break;
+		case NSTAGES - 1:
+			assert(r->seq == *next);
+			assert(r->acc == r->seq * 2 + NSTAGES - 2);
+			(*next)++;
+			break;
+		default:
+			r->acc++;
+			break;
+		}
+		r->stage++;
+		n++;
+	}
+	ringbuf_pipe_done(pl, i, len);
+	return n;
+}
+
+static void
+test_basic(void)
+{
+	uint64_t seq = 0, next = 0;
+	size_t off;
+
+	setup(NSTAGES);
+
+	/* Nothing to do. */
+	for (unsigned i = 0; i < NSTAGES; i++) {
+		assert(ringbuf_pipe_get(pl, i, &off) == 0);
+	}
+
+	/* The stages advance only up to the previous one. */
+	assert(produce_rec(seq++) && produce_rec(seq++));
+	assert(ringbuf_pipe_get(pl, 1, &off) == 0);
+	assert(process(0, &next) == 2);
+	assert(ringbuf_pipe_get(pl, 2, &off) == 0);
+	assert(process(1, &next) == 2);
+	assert(process(2, &next) == 2 && next == 2);
+
+	/* The space is released only once the last stage is done. */
+	for (unsigned n = 0; n < 1000; n++) {
+		while (produce_rec(seq)) {
+			seq++;
+		}
+		for (unsigned i = 0; i < NSTAGES; i++) {
+			process(i, &next);
+		}
+	}
+	for (unsigned i = 0; i < NSTAGES; i++) {
+		process(i, &next);
+	}
+	assert(next == seq && seq > 1000 * 2);
+	teardown();
+}
+
+static void *
+producer(void *arg)
+{
+	(void)arg;
+	for (uint64_t seq = 0; seq < NRECS; seq++) {
+		while (!produce_rec(seq)) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void *
+stage(void *arg)
+{
+	const unsigned i = (uintptr_t)arg;
+	uint64_t next = 0, n = 0;
+
+	while (n < NRECS) {
+		const unsigned c = process(i, &next);
+
+		if (c == 0) {
+			sched_yield();
+		}
+		n += c;
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t thr[NSTAGES + 1];
+
+	setup(NSTAGES);
+	pthread_create(&thr[0], NULL, producer, NULL);
+	for (unsigned i = 0; i < NSTAGES; i++) {
+		pthread_create(&thr[i + 1], NULL, stage, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < NSTAGES + 1; i++) {
+		pthread_join(thr[i], NULL);
+	}
+	teardown();
+}
+
+int
+main(void)
+{
+	test_basic();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
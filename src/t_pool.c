@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_pool.h"
+
+#define	NBLOCKS		8
+#define	NTHREADS	4
+
+static ringbuf_pool_t *	pool;
+
+static void
+test_basic(void)
+{
+	void *blk[NBLOCKS];
+
+	for (unsigned i = 0; i < NBLOCKS; i++) {
+		blk[i] = ringbuf_pool_alloc(pool);
+		assert(blk[i] != NULL);
+		assert(ringbuf_pool_block(pool,
+		    ringbuf_pool_index(pool, blk[i])) == blk[i]);
+		memset(blk[i], 0, ringbuf_pool_blksize(pool));
+	}
+	assert(ringbuf_pool_alloc(pool) == NULL);
+
+	for (unsigned i = 0; i < NBLOCKS; i++) {
+		ringbuf_pool_free(pool, blk[i]);
+	}
+	for (unsigned i = 0; i < NBLOCKS; i++) {
+		blk[i] = ringbuf_pool_alloc(pool);
+		assert(blk[i] != NULL);
+	}
+	for (unsigned i = 0; i < NBLOCKS; i++) {
+		ringbuf_pool_free(pool, blk[i]);
+	}
+}
+
+static void *
+pool_stress(void *arg)
+{
+	const unsigned char id = (uintptr_t)arg;
+
+	/*
+	 * Allocate, mark and verify the blocks: a block must never be
+	 * handed out twice.
+	 */
+	for (unsigned i = 0; i < 200000; i++) {
+		unsigned char *p;
+
+		if ((p = ringbuf_pool_alloc(pool)) == NULL) {
+			continue;
+		}
+		memset(p, id, 64);
+		assert(p[0] == id && p[63] == id);
+		ringbuf_pool_free(pool, p);
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t thr[NTHREADS];
+
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		pthread_create(&thr[i], NULL, pool_stress,
+		    (void *)(uintptr_t)(i + 1));
+	}
+	for (unsigned i = 0; i < NTHREADS; i++) {
+		pthread_join(thr[i], NULL);
+	}
+
+	/* All blocks must be back. */
+	test_basic();
+}
+
+int
+main(void)
+{
+	int ret;
+
+	pool = malloc(ringbuf_pool_get_size(NBLOCKS, 100));
+	ret = ringbuf_pool_setup(pool, NBLOCKS, 100);
+	assert(ret == 0); (void)ret;
+	assert(ringbuf_pool_blksize(pool) == 128);
+
+	test_basic();
+	test_concurrent();
+	free(pool);
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ringbuf_profile.h"
+
+#define	MAX_WORKERS	1
+#define	RBUF_SIZE	4096
+#define	RECLEN		100
+
+static void
+test_usage(void)
+{
+	size_t size, off;
+	ringbuf_t *r;
+	ringbuf_worker_t *w;
+	ssize_t ret;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	r = malloc(size);
+	ringbuf_setup(r, MAX_WORKERS, 1000);
+	w = ringbuf_register(r, 0);
+
+	assert(ringbuf_get_usage(r) == 0);
+	ret = ringbuf_acquire(r, w, 600);
+	assert(ret == 0);
+	assert(ringbuf_get_usage(r) == 600);
+	ringbuf_produce(r, w);
+	assert(ringbuf_consume(r, &off) == 600);
+	ringbuf_release(r, 500);
+	assert(ringbuf_get_usage(r) == 100);
+
+	/* Wrap-around: the end at 600 and 450 bytes at the front. */
+	ret = ringbuf_acquire(r, w, 450);
+	assert(ret == 0); (void)ret;
+	ringbuf_produce(r, w);
+	assert(ringbuf_get_usage(r) == 100 + 450);
+
+	free(r);
+}
+
+static void
+test_profile(void)
+{
+	ringbuf_profile_stats_t stats[RINGBUF_PROFILE_NWINDOWS];
+	ringbuf_profile_t *p = malloc(ringbuf_profile_get_size());
+	size_t size, off, len, advice;
+	ringbuf_worker_t *w;
+	ringbuf_t *r;
+	unsigned n;
+	int ret;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	r = malloc(size);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	w = ringbuf_register(r, 0);
+
+	ret = ringbuf_profile_setup(p, 0, 0);
+	assert(ret == -1);
+	ret = ringbuf_profile_setup(p, 100, 1000);
+	assert(ret == 0); (void)ret;
+	assert(ringbuf_profile_advise(p, 0.01) == 0);
+
+	/*
+	 * Five records outstanding at the sample time, but a burst of
+	 * thirty records every tenth time unit.
+	 */
+	for (uint64_t t = 0; t < 1000; t++) {
+		const unsigned nrecs = (t % 10 == 0) ? 30 : 5;
+
+		for (unsigned i = 0; i < nrecs; i++) {
+			ssize_t ret2 = ringbuf_profile_acquire(p, r, w, RECLEN);
+			assert(ret2 != -1); (void)ret2;
+			ringbuf_produce(r, w);
+		}
+		ringbuf_profile_sample(p, r, t);
+		while ((len = ringbuf_consume(r, &off)) != 0) {
+			ringbuf_release(r, len);
+		}
+	}
+
+	n = ringbuf_profile_windows(p, stats, RINGBUF_PROFILE_NWINDOWS);
+	assert(n == 9);
+	for (unsigned i = 0; i < n; i++) {
+		assert(stats[i].nsamples == 100);
+		assert(stats[i].peak == 30 * RECLEN);
+		assert(stats[i].nbursts == 10);
+		assert(stats[i].burst_max == 0);
+		assert(stats[i].nfail == 0);
+	}
+	assert(stats[0].start == 800 && stats[8].start == 0);
+
+	/* Dropping the bursts is within 20%, but not within 1%. */
+	advice = ringbuf_profile_advise(p, 0.2);
+	assert(advice >= 5 * RECLEN + RECLEN && advice < 1024);
+	advice = ringbuf_profile_advise(p, 0.01);
+	assert(advice >= 30 * RECLEN + RECLEN && advice <= 3600);
+
+	/*
+	 * Sustained overload: the failed request counts as the demand
+	 * and the burst lasts for the whole period.
+	 */
+	for (uint64_t t = 1000; t < 1100; t++) {
+		while (ringbuf_profile_acquire(p, r, w, RECLEN) != -1) {
+			ringbuf_produce(r, w);
+		}
+		for (unsigned i = 0; i < 10; i++) {
+			ssize_t ret2 = ringbuf_profile_acquire(p, r, w, RECLEN);
+			assert(ret2 == -1); (void)ret2;
+		}
+		ringbuf_profile_sample(p, r, t);
+		while ((len = ringbuf_consume(r, &off)) != 0) {
+			ringbuf_release(r, len);
+		}
+	}
+	n = ringbuf_profile_windows(p, stats, 1);
+	assert(n == 1 && stats[0].start == 900);
+	ringbuf_profile_sample(p, r, 1100);
+	n = ringbuf_profile_windows(p, stats, 1);
+	assert(n == 1 && stats[0].start == 1000);
+	assert(stats[0].nfail == 100 * 11);
+	assert(stats[0].nbursts == 1 && stats[0].burst_max == 99);
+
+	advice = ringbuf_profile_advise(p, 0.01);
+	assert(advice > RBUF_SIZE && advice < 2 * RBUF_SIZE);
+
+	/*
+	 * A producer spinning on a full ring: the retries of the same
+	 * record count once, not as the demand of a thousand records.
+	 */
+	ret = ringbuf_profile_setup(p, 100, 1000);
+	assert(ret == 0);
+	for (uint64_t t = 0; t < 100; t++) {
+		while (ringbuf_profile_acquire(p, r, w, RECLEN) != -1) {
+			ringbuf_produce(r, w);
+		}
+		for (unsigned i = 0; i < 1000; i++) {
+			ssize_t ret2 = ringbuf_profile_acquire(p, r, w, RECLEN);
+			assert(ret2 == -1); (void)ret2;
+		}
+		ringbuf_profile_sample(p, r, t);
+		while ((len = ringbuf_consume(r, &off)) != 0) {
+			ringbuf_release(r, len);
+		}
+	}
+	advice = ringbuf_profile_advise(p, 0.01);
+	assert(advice > RBUF_SIZE && advice < 2 * RBUF_SIZE);
+
+	free(p);
+	free(r);
+}
+
+int
+main(void)
+{
+	test_usage();
+	test_profile();
+	puts("ok");
+	return 0;
+}
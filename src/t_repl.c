@@ -0,0 +1,432 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <assert.h>
+#include <errno.h>
+
+#include "ringbuf_repl.h"
+#include "ringbuf_frame.h"
+
+#define	MAX_WORKERS	2
+#define	RBUF_SIZE	4096
+#define	NRECS		100000
+
+static ringbuf_t *
+ring_create(void)
+{
+	ringbuf_t *r;
+	size_t rsize;
+
+	ringbuf_get_sizes(MAX_WORKERS, &rsize, NULL);
+	r = malloc(rsize);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	return r;
+}
+
+static void
+produce_seq(ringbuf_t *r, ringbuf_worker_t *w, void *buf, uint32_t seq)
+{
+	ringbuf_frame_t *f;
+	const size_t len = sizeof(uint32_t) * (1 + seq % 7);
+	uint32_t *p;
+
+	f = ringbuf_frame_acquire(r, w, buf, len, NULL);
+	assert(f != NULL);
+	p = ringbuf_frame_data(f);
+	for (unsigned i = 0; i < len / sizeof(uint32_t); i++) {
+		p[i] = seq;
+	}
+	ringbuf_frame_produce(r, w, f);
+}
+
+static void
+test_basic(void)
+{
+	uint64_t sbuf[RBUF_SIZE / 8], dbuf[RBUF_SIZE / 8];
+	ringbuf_t *src = ring_create(), *dst = ring_create();
+	ringbuf_worker_t *sw = ringbuf_register(src, 0);
+	ringbuf_worker_t *dw = ringbuf_register(dst, 0);
+	ringbuf_repl_t *rs, *rd, *rt;
+	ringbuf_frame_iter_t it;
+	ringbuf_frame_t *f;
+	size_t len, off, shipped = 0, received = 0;
+	unsigned seen = 0;
+	ssize_t n;
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+		abort();
+	}
+	rs = ringbuf_repl_create(sv[0], 64);
+	rd = ringbuf_repl_create(sv[1], 64);
+	ringbuf_frame_iter_init(&it, dst, dbuf);
+
+	/* Nothing to ship or to acknowledge. */
+	assert(ringbuf_repl_send(rs, src, sbuf) == 0);
+	assert(ringbuf_repl_ack(rs, src, 0) == 0);
+
+	/* A record larger than the batch. */
+	rt = ringbuf_repl_create(sv[0], 8);
+	produce_seq(src, sw, sbuf, 0);
+	n = ringbuf_repl_send(rt, src, sbuf);
+	assert(n == -1 && errno == EMSGSIZE);
+	ringbuf_repl_destroy(rt);
+
+	/* Ten records: the batches are cut at the record boundaries. */
+	for (unsigned i = 1; i < 10; i++) {
+		produce_seq(src, sw, sbuf, i);
+	}
+	while ((n = ringbuf_repl_send(rs, src, sbuf)) > 0) {
+		assert(n <= 64 && n % RINGBUF_FRAME_ALIGN == 0);
+		shipped += n;
+	}
+	assert(n == 0 && shipped > 64);
+
+	/* Not yet acknowledged: the data is still in the source ring. */
+	len = ringbuf_consume(src, &off);
+	assert(off == 0 && len == shipped);
+
+	while (received < shipped) {
+		n = ringbuf_repl_recv(rd, dst, dw, dbuf);
+		assert(n > 0);
+		received += n;
+	}
+	assert(received == shipped);
+
+	/* Acknowledged: released in the source ring. */
+	n = ringbuf_repl_ack(rs, src, 0);
+	assert(n == (ssize_t)shipped);
+	assert(ringbuf_consume(src, &off) == 0);
+
+	/* The same records come out of the destination ring. */
+	while (ringbuf_frame_consume(&it, 0)) {
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			const uint32_t *p = ringbuf_frame_data(f);
+
+			assert(f->len == sizeof(uint32_t) * (1 + seen % 7));
+			assert(p[0] == seen);
+			seen++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	assert(seen == 10);
+
+	/* The end of stream. */
+	close(sv[0]);
+	n = ringbuf_repl_recv(rd, dst, dw, dbuf);
+	assert(n == -1 && errno == ECONNRESET);
+
+	ringbuf_repl_destroy(rs);
+	ringbuf_repl_destroy(rd);
+	close(sv[1]);
+	free(src);
+	free(dst);
+}
+
+static void
+test_errors(void)
+{
+	uint64_t sbuf[RBUF_SIZE / 8], dbuf[RBUF_SIZE / 8];
+	ringbuf_t *src = ring_create(), *dst = ring_create();
+	ringbuf_worker_t *sw = ringbuf_register(src, 0);
+	ringbuf_worker_t *dw = ringbuf_register(dst, 0);
+	ringbuf_pool_t *pool = malloc(ringbuf_pool_get_size(1, 1000));
+	ringbuf_frame_opts_t opts = { .indirect = 64 };
+	ringbuf_repl_t *rs, *rd;
+	ringbuf_frame_iter_t it;
+	ringbuf_frame_t *f;
+	uint8_t wire[64];
+	ssize_t n, len;
+	int sv[2], tv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1 ||
+	    socketpair(AF_UNIX, SOCK_STREAM, 0, tv) == -1) {
+		abort();
+	}
+	ringbuf_pool_setup(pool, 1, 1000);
+	opts.pool = pool;
+	rs = ringbuf_repl_create(sv[0], 64);
+	rd = ringbuf_repl_create(tv[1], 64);
+	ringbuf_frame_iter_init(&it, dst, dbuf);
+
+	/* The out-of-line record is not shipped. */
+	produce_seq(src, sw, sbuf, 1);
+	f = ringbuf_frame_acquire(src, sw, sbuf, 1000, &opts);
+	assert(f != NULL && (f->flags & RINGBUF_FRAME_BLOB) != 0);
+	ringbuf_frame_produce(src, sw, f);
+
+	n = ringbuf_repl_send(rs, src, sbuf);
+	assert(n == 16);
+	n = ringbuf_repl_send(rs, src, sbuf);
+	assert(n == -1 && errno == ENOTSUP);
+
+	/* Neither are the records of a transaction or the keyed ones. */
+	for (unsigned i = 0; i < 2; i++) {
+		const ringbuf_frame_opts_t o = { .txn = i == 0, .keyed = i };
+		uint64_t tbuf[RBUF_SIZE / 8];
+		ringbuf_t *tr = ring_create();
+		ringbuf_worker_t *tw = ringbuf_register(tr, 0);
+		ringbuf_repl_t *rt = ringbuf_repl_create(sv[0], 64);
+
+		f = ringbuf_frame_acquire(tr, tw, tbuf, 8, &o);
+		assert(f != NULL);
+		ringbuf_frame_produce(tr, tw, f);
+		assert(ringbuf_repl_send(rt, tr, tbuf) == -1);
+		assert(errno == ENOTSUP);
+		ringbuf_repl_destroy(rt);
+		free(tr);
+	}
+
+	/* A full batch could never fit the destination ring. */
+	{
+		ringbuf_repl_t *rt = ringbuf_repl_create(tv[1], RBUF_SIZE);
+
+		n = ringbuf_repl_recv(rt, dst, dw, dbuf);
+		assert(n == -1 && errno == EINVAL);
+		ringbuf_repl_destroy(rt);
+	}
+
+	/*
+	 * Truncate the shipped batch: the receive fails before the space
+	 * is acquired, so the records of other producers are reachable.
+	 */
+	len = recv(sv[1], wire, sizeof(wire), 0);
+	assert(len > n);
+	if (send(tv[0], wire, len - 8, 0) != len - 8) {
+		abort();
+	}
+	close(tv[0]);
+	n = ringbuf_repl_recv(rd, dst, dw, dbuf);
+	assert(n == -1 && errno == ECONNRESET);
+
+	produce_seq(dst, ringbuf_register(dst, 1), dbuf, 3);
+	assert(ringbuf_frame_consume(&it, 0) > 0);
+	f = ringbuf_frame_next(&it);
+	assert(f && *(uint32_t *)ringbuf_frame_data(f) == 3);
+	assert(ringbuf_frame_next(&it) == NULL);
+	ringbuf_frame_release(&it);
+
+	/* The endpoint is broken: the error is sticky. */
+	n = ringbuf_repl_recv(rd, dst, dw, dbuf);
+	assert(n == -1 && errno == ECONNRESET);
+
+	ringbuf_repl_destroy(rs);
+	ringbuf_repl_destroy(rd);
+	close(sv[0]);
+	close(sv[1]);
+	close(tv[1]);
+	free(pool);
+	free(src);
+	free(dst);
+}
+
+/*
+ * No space in the destination ring: the batch stays staged, while the
+ * ring is not blocked, and is produced once the space is released.
+ */
+static void
+test_nobufs(void)
+{
+	uint64_t sbuf[RBUF_SIZE / 8], dbuf[RBUF_SIZE / 8];
+	ringbuf_t *src = ring_create(), *dst = ring_create();
+	ringbuf_worker_t *sw = ringbuf_register(src, 0);
+	ringbuf_worker_t *dw = ringbuf_register(dst, 0);
+	ringbuf_worker_t *other = ringbuf_register(dst, 1);
+	ringbuf_repl_t *rs, *rd;
+	ringbuf_frame_t *f;
+	size_t len, off;
+	ssize_t n;
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+		abort();
+	}
+	rs = ringbuf_repl_create(sv[0], 64);
+	rd = ringbuf_repl_create(sv[1], 64);
+
+	produce_seq(src, sw, sbuf, 0);
+	assert(ringbuf_repl_send(rs, src, sbuf) == 16);
+
+	/* Fill the destination ring by another producer. */
+	assert(ringbuf_acquire(dst, other, RBUF_SIZE - 8) == 0);
+	ringbuf_produce(dst, other);
+	n = ringbuf_repl_recv(rd, dst, dw, dbuf);
+	assert(n == -1 && errno == ENOBUFS);
+
+	/* Nothing is reserved: the filler is consumed alone. */
+	len = ringbuf_consume(dst, &off);
+	assert(off == 0 && len == RBUF_SIZE - 8);
+	ringbuf_release(dst, len);
+
+	n = ringbuf_repl_recv(rd, dst, dw, dbuf);
+	assert(n == 16);
+	len = ringbuf_consume(dst, &off);
+	assert(len == 16);
+	f = (void *)((uint8_t *)dbuf + off);
+	assert(f->len == 4 && *(uint32_t *)ringbuf_frame_data(f) == 0);
+	ringbuf_release(dst, len);
+	assert(ringbuf_repl_ack(rs, src, 0) == 16);
+
+	ringbuf_repl_destroy(rs);
+	ringbuf_repl_destroy(rd);
+	close(sv[0]);
+	close(sv[1]);
+	free(src);
+	free(dst);
+}
+
+/*
+ * Concurrent test: a producer into the source ring, a thread shipping
+ * it and a thread receiving into the destination ring, which is drained
+ * and verified by the main thread.
+ */
+
+static ringbuf_t *		src_ring, *dst_ring;
+static uint64_t			src_buf[RBUF_SIZE / 8], dst_buf[RBUF_SIZE / 8];
+static ringbuf_repl_t *		repl_src, *repl_dst;
+static volatile bool		done;
+
+static void *
+producer(void *arg)
+{
+	ringbuf_worker_t *w = ringbuf_register(src_ring, 0);
+
+	(void)arg;
+	for (uint32_t seq = 0; seq < NRECS; seq++) {
+		for (;;) {
+			ringbuf_frame_t *f;
+			const size_t len = sizeof(uint32_t) * (1 + seq % 7);
+			uint32_t *p;
+
+			f = ringbuf_frame_acquire(src_ring, w, src_buf,
+			    len, NULL);
+			if (f == NULL) {
+				sched_yield();
+				continue;
+			}
+			p = ringbuf_frame_data(f);
+			for (unsigned i = 0; i < len / sizeof(uint32_t); i++) {
+				p[i] = seq;
+			}
+			ringbuf_frame_produce(src_ring, w, f);
+			break;
+		}
+	}
+	ringbuf_unregister(src_ring, w);
+	return NULL;
+}
+
+static void *
+shipper(void *arg)
+{
+	(void)arg;
+	while (!done) {
+		const ssize_t n = ringbuf_repl_send(repl_src, src_ring,
+		    src_buf);
+
+		assert(n != -1);
+		if (n == 0) {
+			assert(ringbuf_repl_ack(repl_src, src_ring,
+			    MSG_DONTWAIT) != -1);
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void *
+receiver(void *arg)
+{
+	ringbuf_worker_t *w = ringbuf_register(dst_ring, 0);
+
+	(void)arg;
+	for (;;) {
+		if (ringbuf_repl_recv(repl_dst, dst_ring, w, dst_buf) == -1) {
+			if (errno == ENOBUFS) {
+				sched_yield();
+				continue;
+			}
+			assert(errno == ECONNRESET);
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t thr[3];
+	ringbuf_frame_iter_t it;
+	uint32_t seen = 0;
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+		abort();
+	}
+	src_ring = ring_create();
+	dst_ring = ring_create();
+	repl_src = ringbuf_repl_create(sv[0], RBUF_SIZE / 4);
+	repl_dst = ringbuf_repl_create(sv[1], RBUF_SIZE / 4);
+	ringbuf_frame_iter_init(&it, dst_ring, dst_buf);
+
+	pthread_create(&thr[0], NULL, producer, NULL);
+	pthread_create(&thr[1], NULL, shipper, NULL);
+	pthread_create(&thr[2], NULL, receiver, NULL);
+
+	while (seen < NRECS) {
+		ringbuf_frame_t *f;
+
+		if (ringbuf_frame_consume(&it, 0) == 0) {
+			sched_yield();
+			continue;
+		}
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			const uint32_t *p = ringbuf_frame_data(f);
+
+			assert(f->len == sizeof(uint32_t) * (1 + seen % 7));
+			for (unsigned i = 0; i < f->len / 4; i++) {
+				assert(p[i] == seen);
+			}
+			seen++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	done = true;
+
+	pthread_join(thr[0], NULL);
+	pthread_join(thr[1], NULL);
+	close(sv[0]);
+	pthread_join(thr[2], NULL);
+	close(sv[1]);
+
+	ringbuf_repl_destroy(repl_src);
+	ringbuf_repl_destroy(repl_dst);
+	free(src_ring);
+	free(dst_ring);
+}
+
+int
+main(void)
+{
+	test_basic();
+	test_errors();
+	test_nobufs();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
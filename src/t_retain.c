@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_retain.h"
+
+#define	MAX_WORKERS	1
+#define	RBUF_SIZE	4096
+#define	NINDEX		512
+#define	NRECS		100000
+
+static uint64_t		rbuf[RBUF_SIZE / sizeof(uint64_t)];
+static ringbuf_t *	ring;
+static ringbuf_worker_t *worker;
+static ringbuf_retain_t *rt;
+static volatile bool	done;
+
+static void
+setup(void)
+{
+	size_t size;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	ring = malloc(size);
+	ringbuf_setup(ring, MAX_WORKERS, RBUF_SIZE);
+	worker = ringbuf_register(ring, 0);
+	rt = ringbuf_retain_create(ring, rbuf, NINDEX);
+	assert(rt != NULL);
+}
+
+static void
+teardown(void)
+{
+	ringbuf_retain_destroy(rt);
+	free(ring);
+}
+
+static bool
+produce_rec(uint64_t val)
+{
+	ringbuf_frame_t *f;
+
+	/* The payload length varies, but the first word is the value. */
+	f = ringbuf_frame_acquire(ring, worker, rbuf, 8 + (val % 5) * 8, NULL);
+	if (f == NULL) {
+		return false;
+	}
+	memset(ringbuf_frame_data(f), 0, f->len);
+	memcpy(ringbuf_frame_data(f), &val, 8);
+	ringbuf_frame_produce(ring, worker, f);
+	return true;
+}
+
+/*
+ * consume_all: consume and index all records, checking that the
+ * sequence numbers follow the values.
+ */
+static void
+consume_all(ringbuf_frame_iter_t *it)
+{
+	ringbuf_frame_t *f;
+
+	while (ringbuf_frame_consume(it, 0)) {
+		while ((f = ringbuf_frame_next(it)) != NULL) {
+			uint64_t val;
+
+			memcpy(&val, ringbuf_frame_data(f), 8);
+			assert(ringbuf_retain_add(rt, f) == val);
+		}
+		ringbuf_frame_release(it);
+	}
+}
+
+static void
+check_rec(uint64_t seq)
+{
+	uint64_t data[8];
+	ssize_t ret;
+
+	ret = ringbuf_retain_read(rt, seq, data, sizeof(data));
+	assert(ret == (ssize_t)(8 + (seq % 5) * 8));
+	assert(data[0] == seq);
+}
+
+static void
+test_history(void)
+{
+	ringbuf_frame_iter_t it;
+	uint64_t seq = 0, oldest, data[8];
+
+	setup();
+	ringbuf_frame_iter_init(&it, ring, rbuf);
+
+	/* Empty. */
+	assert(ringbuf_retain_next(rt) == 0);
+	assert(ringbuf_retain_oldest(rt) == 0);
+	assert(ringbuf_retain_read(rt, 0, data, sizeof(data)) == -1);
+	assert(errno == ENOENT);
+
+	/* Released, but still retained. */
+	for (unsigned i = 0; i < 10; i++) {
+		assert(produce_rec(seq++));
+	}
+	consume_all(&it);
+	assert(ringbuf_retain_next(rt) == 10);
+	assert(ringbuf_retain_oldest(rt) == 0);
+	for (uint64_t s = 0; s < 10; s++) {
+		check_rec(s);
+	}
+	assert(ringbuf_retain_read(rt, 1, data, 8) == -1);
+	assert(errno == EMSGSIZE);
+
+	/* The producers overwrite the oldest records only as needed. */
+	while (produce_rec(seq)) {
+		seq++;
+	}
+	assert(ringbuf_retain_read(rt, 0, data, sizeof(data)) == -1);
+	assert(errno == ESTALE);
+	consume_all(&it);
+
+	/* Many laps: the window moves along. */
+	for (unsigned n = 0; n < 100; n++) {
+		for (unsigned i = 0; i < 50; i++) {
+			assert(produce_rec(seq++));
+			if (i % 10 == 0) {
+				consume_all(&it);
+			}
+		}
+		consume_all(&it);
+
+		oldest = ringbuf_retain_oldest(rt);
+		assert(oldest > 0 && oldest < seq);
+		assert(seq - oldest <= NINDEX);
+		for (uint64_t s = oldest; s < seq; s++) {
+			check_rec(s);
+		}
+		assert(ringbuf_retain_read(rt, oldest - 1,
+		    data, sizeof(data)) == -1);
+		assert(errno == ESTALE || errno == ENOENT);
+		assert(ringbuf_retain_read(rt, seq, data, sizeof(data)) == -1);
+		assert(errno == ENOENT);
+	}
+	teardown();
+}
+
+static void *
+reader(void *arg)
+{
+	uint64_t nread = 0, nstale = 0;
+
+	(void)arg;
+	while (!done) {
+		const uint64_t next = ringbuf_retain_next(rt);
+		const uint64_t oldest = ringbuf_retain_oldest(rt);
+		uint64_t data[8];
+
+		/* Catch up from the oldest record. */
+		for (uint64_t s = oldest; s < next; s++) {
+			ssize_t ret;
+
+			ret = ringbuf_retain_read(rt, s, data, sizeof(data));
+			if (ret == -1) {
+				assert(errno == ESTALE || errno == ENOENT);
+				nstale++;
+				break;
+			}
+			assert(ret == (ssize_t)(8 + (s % 5) * 8));
+			assert(data[0] == s);
+			nread++;
+		}
+		sched_yield();
+	}
+	assert(nread > 0);
+	(void)nstale;
+	return NULL;
+}
+
+static void *
+producer(void *arg)
+{
+	(void)arg;
+	for (uint64_t seq = 0; seq < NRECS; seq++) {
+		while (!produce_rec(seq)) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	ringbuf_frame_iter_t it;
+	pthread_t thr[2];
+
+	setup();
+	ringbuf_frame_iter_init(&it, ring, rbuf);
+	pthread_create(&thr[0], NULL, producer, NULL);
+	pthread_create(&thr[1], NULL, reader, NULL);
+	while (ringbuf_retain_next(rt) < NRECS) {
+		consume_all(&it);
+		sched_yield();
+	}
+	done = true;
+	pthread_join(thr[0], NULL);
+	pthread_join(thr[1], NULL);
+	teardown();
+}
+
+int
+main(void)
+{
+	test_history();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
@@ -7,6 +7,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #include "ringbuf.h"
@@ -266,6 +267,52 @@ test_random(void)
 	free(r);
 }
 
+static void
+test_peek(void)
+{
+	ringbuf_t *r = malloc(ringbuf_obj_size);
+	ringbuf_worker_t *w;
+	size_t len, off, woff;
+	uint64_t gen;
+	ssize_t ret;
+
+	ringbuf_setup(r, MAX_WORKERS, 1000);
+	w = ringbuf_register(r, 0);
+
+	/* Nothing to peek. */
+	len = ringbuf_peek(r, &off, &gen);
+	assert(len == 0);
+
+	/* In-flight data is not visible. */
+	ret = ringbuf_acquire(r, w, 600);
+	assert(ret == 0);
+	len = ringbuf_peek(r, &off, &gen);
+	assert(len == 0);
+	ringbuf_produce(r, w);
+
+	/* Peek does not consume. */
+	len = ringbuf_peek(r, &off, &gen);
+	assert(len == 600 && off == 0);
+	assert(ringbuf_peek_validate(r, gen) == 0);
+	len = ringbuf_consume(r, &woff);
+	assert(len == 600 && woff == 0);
+
+	/* Released range invalidates the peek. */
+	ringbuf_release(r, len);
+	assert(ringbuf_peek_validate(r, gen) == -1);
+
+	/* Peek across the consumer wrap-around. */
+	ret = ringbuf_acquire(r, w, 500);
+	assert(ret == 0);
+	ringbuf_produce(r, w);
+	len = ringbuf_peek(r, &off, &gen);
+	assert(len == 500 && off == 0);
+	assert(ringbuf_peek_validate(r, gen) == 0);
+
+	ringbuf_unregister(r, w);
+	free(r);
+}
+
 int
 main(void)
 {
@@ -274,6 +321,7 @@ main(void)
 	test_multi();
 	test_overlap();
 	test_random();
+	test_peek();
 	puts("ok");
 	return 0;
 }
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_sched.h"
+#include "ringbuf_txn.h"
+
+#define	NRINGS		2
+#define	MAX_WORKERS	1
+#define	NBURSTS		20
+#define	BURST		100
+
+static size_t		ringbuf_obj_size;
+static ringbuf_t *	rings[NRINGS];
+static ringbuf_worker_t *workers[NRINGS];
+static uint64_t		bufs[NRINGS][512];
+static ringbuf_sched_t *sched;
+
+static void
+setup_rings(void)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		rings[i] = malloc(ringbuf_obj_size);
+		ringbuf_setup(rings[i], MAX_WORKERS, sizeof(bufs[i]));
+		workers[i] = ringbuf_register(rings[i], 0);
+	}
+}
+
+static void
+destroy_rings(void)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		free(rings[i]);
+	}
+}
+
+static bool
+produce_msg(unsigned i, uint32_t val)
+{
+	ringbuf_frame_t *f;
+
+	f = ringbuf_frame_acquire(rings[i], workers[i], bufs[i], 4, NULL);
+	if (f == NULL) {
+		return false;
+	}
+	memcpy(ringbuf_frame_data(f), &val, 4);
+	ringbuf_frame_produce(rings[i], workers[i], f);
+	return true;
+}
+
+static void
+count_handler(void *arg, unsigned ring, ringbuf_frame_t *f)
+{
+	unsigned *counts = arg;
+	uint32_t val;
+
+	memcpy(&val, ringbuf_frame_data(f), 4);
+	assert(val == counts[ring]);
+	counts[ring]++;
+}
+
+static void
+test_budget(void)
+{
+	const ringbuf_sched_params_t params = {
+		.budget = 4, .poll_rounds = 1000, .poll_rate = 1,
+	};
+	ringbuf_sched_stats_t stats;
+	unsigned counts[NRINGS] = { 0 }, n;
+
+	setup_rings();
+	sched = ringbuf_sched_create(NRINGS, &params);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_sched_add(sched, i, rings[i], bufs[i]);
+	}
+
+	/* Ten records in the first ring and two in the second. */
+	for (unsigned i = 0; i < 10; i++) {
+		produce_msg(0, i);
+	}
+	produce_msg(1, 0);
+	produce_msg(1, 1);
+
+	n = ringbuf_sched_poll(sched, count_handler, counts);
+	assert(n == 4 + 2 && counts[0] == 4 && counts[1] == 2);
+	n = ringbuf_sched_poll(sched, count_handler, counts);
+	assert(n == 4 && counts[0] == 8);
+	n = ringbuf_sched_poll(sched, count_handler, counts);
+	assert(n == 2 && counts[0] == 10);
+	n = ringbuf_sched_poll(sched, count_handler, counts);
+	assert(n == 0);
+
+	ringbuf_sched_stats(sched, &stats);
+	assert(stats.nrounds == 4 && stats.nrecords == 12);
+	assert(stats.nbudget == 2);
+	assert(stats.mode == RINGBUF_SCHED_POLL && stats.nsleeps == 0);
+
+	/* Byte budget: two 4-byte payloads. */
+	ringbuf_sched_destroy(sched);
+	sched = ringbuf_sched_create(NRINGS, &(ringbuf_sched_params_t){
+	    .budget = 4, .budget_bytes = 8, .poll_rounds = 1000 });
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_sched_add(sched, i, rings[i], bufs[i]);
+	}
+	for (unsigned i = 10; i < 13; i++) {
+		produce_msg(0, i);
+	}
+	n = ringbuf_sched_poll(sched, count_handler, counts);
+	assert(n == 2 && counts[0] == 12);
+	n = ringbuf_sched_poll(sched, count_handler, counts);
+	assert(n == 1 && counts[0] == 13);
+
+	ringbuf_sched_destroy(sched);
+	destroy_rings();
+}
+
+static void *
+producer(void *arg)
+{
+	uint32_t vals[NRINGS] = { 0 };
+
+	(void)arg;
+	for (unsigned b = 0; b < NBURSTS; b++) {
+		/* A burst into both rings, then a pause. */
+		for (unsigned i = 0; i < BURST * NRINGS; i++) {
+			const unsigned ring = i % NRINGS;
+
+			while (!produce_msg(ring, vals[ring])) {
+				ringbuf_sched_notify(sched);
+				sched_yield();
+			}
+			vals[ring]++;
+			ringbuf_sched_notify(sched);
+		}
+		usleep(5000);
+	}
+	return NULL;
+}
+
+static void
+test_adaptive(void)
+{
+	const ringbuf_sched_params_t params = {
+		.budget = 8, .poll_rounds = 16, .poll_rate = 2,
+	};
+	unsigned counts[NRINGS] = { 0 }, total = 0;
+	ringbuf_sched_stats_t stats;
+	pthread_t thr;
+
+	setup_rings();
+	sched = ringbuf_sched_create(NRINGS, &params);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_sched_add(sched, i, rings[i], bufs[i]);
+	}
+
+	pthread_create(&thr, NULL, producer, NULL);
+	while (total < NBURSTS * BURST * NRINGS) {
+		total += ringbuf_sched_poll(sched, count_handler, counts);
+	}
+	pthread_join(thr, NULL);
+
+	/* Blocked during the pauses and polled during the bursts. */
+	ringbuf_sched_stats(sched, &stats);
+	assert(stats.nrecords == total);
+	assert(stats.nintr > 0 && stats.nsleeps > 0);
+	assert(stats.npoll > 0);
+
+	ringbuf_sched_destroy(sched);
+	destroy_rings();
+}
+
+static void *
+committer(void *arg)
+{
+	usleep(50000);
+	ringbuf_txn_commit(arg, 0, NULL, 0);
+	ringbuf_sched_notify(sched);
+	return NULL;
+}
+
+/*
+ * A record of an open transaction is not pending: the consumer sleeps
+ * until the commit, rather than spinning.
+ */
+static void
+test_open_txn(void)
+{
+	const ringbuf_sched_params_t params = {
+		.budget = 8, .poll_rounds = 1, .poll_rate = 1000,
+	};
+	ringbuf_txn_t *txn = malloc(ringbuf_txn_get_size(1));
+	unsigned counts[NRINGS] = { 0 }, n;
+	ringbuf_sched_stats_t stats;
+	ringbuf_txn_rec_t rec;
+	const uint32_t val = 0;
+	pthread_t thr;
+
+	setup_rings();
+	ringbuf_txn_setup(txn, 1);
+	sched = ringbuf_sched_create(NRINGS, &params);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_frame_iter_settxn(ringbuf_sched_add(sched, i,
+		    rings[i], bufs[i]), txn);
+	}
+
+	/* Produced, but the state is set only by the committer. */
+	rec = (ringbuf_txn_rec_t){
+		.rbuf = rings[0], .w = workers[0], .buf = bufs[0], .len = 4,
+	};
+	assert(ringbuf_txn_acquire(txn, 0, &rec, 1) == 0);
+	memcpy(ringbuf_frame_data(rec.frame), &val, 4);
+	ringbuf_frame_produce(rings[0], workers[0], rec.frame);
+
+	pthread_create(&thr, NULL, committer, txn);
+	while ((n = ringbuf_sched_poll(sched, count_handler, counts)) == 0)
+		;
+	pthread_join(thr, NULL);
+	assert(n == 1 && counts[0] == 1);
+
+	ringbuf_sched_stats(sched, &stats);
+	assert(stats.nsleeps > 0);
+
+	ringbuf_sched_destroy(sched);
+	destroy_rings();
+	free(txn);
+}
+
+int
+main(void)
+{
+	ringbuf_get_sizes(MAX_WORKERS, &ringbuf_obj_size, NULL);
+	test_budget();
+	test_adaptive();
+	test_open_txn();
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_set.h"
+
+#define	NRINGS		8
+#define	MAX_WORKERS	2
+#define	RING_SIZE	(64 * 1024)
+#define	RECLEN		56
+#define	NRECS		100000
+
+static ringbuf_t *	rings[NRINGS];
+static uint64_t		bufs[NRINGS][RING_SIZE / sizeof(uint64_t)];
+static volatile bool	done;
+
+static void
+setup_rings(size_t size)
+{
+	size_t objsize;
+
+	ringbuf_get_sizes(MAX_WORKERS, &objsize, NULL);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		rings[i] = malloc(objsize);
+		ringbuf_setup(rings[i], MAX_WORKERS, size);
+	}
+}
+
+static void
+destroy_rings(void)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		free(rings[i]);
+	}
+}
+
+static ringbuf_set_t *
+create_set(unsigned nrings, unsigned worker)
+{
+	ringbuf_set_t *s = ringbuf_set_create(nrings);
+
+	assert(s != NULL);
+	for (unsigned i = 0; i < nrings; i++) {
+		ringbuf_set_add(s, i, rings[i],
+		    ringbuf_register(rings[i], worker), bufs[i]);
+	}
+	return s;
+}
+
+static void
+test_balance(void)
+{
+	unsigned counts[NRINGS] = { 0 }, min = UINT32_MAX, max = 0, ring;
+	ringbuf_worker_t *w;
+	ringbuf_frame_t *f;
+	ringbuf_set_t *s;
+
+	setup_rings(RING_SIZE);
+	s = create_set(NRINGS, 0);
+
+	/* Skew: the first ring is half full. */
+	w = ringbuf_register(rings[0], 1);
+	for (unsigned i = 0; i < RING_SIZE / 2 / (RECLEN + 8); i++) {
+		f = ringbuf_frame_acquire(rings[0], w, bufs[0], RECLEN, NULL);
+		ringbuf_frame_produce(rings[0], w, f);
+	}
+
+	/* No consumers: the records spread evenly, avoiding the first. */
+	for (unsigned n = 0; n < (NRINGS - 1) * 200; n++) {
+		f = ringbuf_set_acquire(s, RECLEN, NULL, &ring);
+		assert(f != NULL && ring < NRINGS);
+		ringbuf_set_produce(s, ring, f);
+		counts[ring]++;
+	}
+	assert(counts[0] == 0);
+	for (unsigned i = 1; i < NRINGS; i++) {
+		min = counts[i] < min ? counts[i] : min;
+		max = counts[i] > max ? counts[i] : max;
+	}
+	assert(max - min <= 8);
+
+	ringbuf_set_destroy(s);
+	destroy_rings();
+}
+
+static void
+test_fallback(void)
+{
+	unsigned ring, n = 0;
+	ringbuf_frame_t *f;
+	ringbuf_set_t *s;
+
+	setup_rings(4096);
+	s = create_set(2, 0);
+
+	/* Both rings get filled up, then there is no space. */
+	while ((f = ringbuf_set_acquire(s, RECLEN, NULL, &ring)) != NULL) {
+		ringbuf_set_produce(s, ring, f);
+		n++;
+	}
+	assert(n >= 2 * (4096 / (RECLEN + 8) - 1));
+	assert(ringbuf_set_acquire(s, RECLEN, NULL, &ring) == NULL);
+
+	ringbuf_set_destroy(s);
+	destroy_rings();
+}
+
+static void *
+producer(void *arg)
+{
+	ringbuf_set_t *s = create_set(NRINGS, (uintptr_t)arg);
+	unsigned ring;
+
+	for (unsigned n = 0; n < NRECS; n++) {
+		ringbuf_frame_t *f;
+
+		while ((f = ringbuf_set_acquire(s, RECLEN,
+		    NULL, &ring)) == NULL) {
+			sched_yield();
+		}
+		memcpy(ringbuf_frame_data(f), &n, sizeof(n));
+		ringbuf_set_produce(s, ring, f);
+	}
+	ringbuf_set_destroy(s);
+	return NULL;
+}
+
+static void *
+consumer(void *arg)
+{
+	const unsigned i = (uintptr_t)arg;
+	ringbuf_frame_iter_t it;
+	uintptr_t count = 0;
+
+	ringbuf_frame_iter_init(&it, rings[i], bufs[i]);
+	for (;;) {
+		const bool last = done;
+		ringbuf_frame_t *f;
+
+		if (ringbuf_frame_consume(&it, 0) == 0) {
+			if (last) {
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			assert(f->len == RECLEN);
+			count++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	return (void *)count;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t prod[MAX_WORKERS], cons[NRINGS];
+	uintptr_t total = 0;
+
+	setup_rings(4096);
+	done = false;
+	for (unsigned i = 0; i < NRINGS; i++) {
+		pthread_create(&cons[i], NULL, consumer, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < MAX_WORKERS; i++) {
+		pthread_create(&prod[i], NULL, producer, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < MAX_WORKERS; i++) {
+		pthread_join(prod[i], NULL);
+	}
+	done = true;
+	for (unsigned i = 0; i < NRINGS; i++) {
+		void *ret;
+
+		pthread_join(cons[i], &ret);
+		assert((uintptr_t)ret > 0);
+		total += (uintptr_t)ret;
+	}
+	assert(total == MAX_WORKERS * NRECS);
+	destroy_rings();
+}
+
+int
+main(void)
+{
+	test_balance();
+	test_fallback();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_split.h"
+
+#define	MAX_WORKERS	1
+#define	NHELPERS	4
+#define	RBUF_SIZE	(1024 * 1024)
+#define	RECLEN		(300 * 1000 + 7)
+
+static uint8_t		rbuf[RBUF_SIZE];
+static uint8_t		src[RECLEN];
+
+typedef struct {
+	ringbuf_split_t *	sp;
+	uint8_t *		dst;
+	unsigned		part;
+} helper_arg_t;
+
+static void
+test_parts(void)
+{
+	ringbuf_split_t sp;
+	size_t off, len, total = 0;
+
+	/* Cache line aligned parts covering the whole range. */
+	ringbuf_split_init(&sp, NULL, NULL, 1000, 3);
+	len = ringbuf_split_part(&sp, 0, &off);
+	assert(off == 0 && len == 384);
+	len = ringbuf_split_part(&sp, 1, &off);
+	assert(off == 384 && len == 384);
+	len = ringbuf_split_part(&sp, 2, &off);
+	assert(off == 768 && len == 232);
+
+	/* Small range: the trailing parts are empty. */
+	ringbuf_split_init(&sp, NULL, NULL, 100, 4);
+	for (unsigned i = 0; i < 4; i++) {
+		len = ringbuf_split_part(&sp, i, &off);
+		assert(off == total);
+		total += len;
+	}
+	assert(total == 100);
+	assert(ringbuf_split_part(&sp, 3, &off) == 0);
+}
+
+static void *
+helper(void *arg)
+{
+	helper_arg_t *ha = arg;
+	size_t off, len;
+
+	len = ringbuf_split_part(ha->sp, ha->part, &off);
+	memcpy(ha->dst + off, src + off, len);
+	ringbuf_split_done(ha->sp);
+	return NULL;
+}
+
+static void
+test_fill(void)
+{
+	ringbuf_worker_t *w;
+	ringbuf_t *r;
+	size_t size;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	r = malloc(size);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	w = ringbuf_register(r, 0);
+
+	for (unsigned n = 0; n < 20; n++) {
+		pthread_t thr[NHELPERS];
+		helper_arg_t args[NHELPERS];
+		ringbuf_split_t sp;
+		size_t off, len;
+		ssize_t ret;
+
+		for (unsigned i = 0; i < RECLEN; i++) {
+			src[i] = (uint8_t)(n * 31 + i);
+		}
+		ret = ringbuf_acquire(r, w, RECLEN);
+		assert(ret != -1);
+
+		/* The helpers fill all parts, but the last one. */
+		ringbuf_split_init(&sp, r, w, RECLEN, NHELPERS + 1);
+		for (unsigned i = 0; i < NHELPERS; i++) {
+			args[i].sp = &sp;
+			args[i].dst = &rbuf[ret];
+			args[i].part = i;
+			pthread_create(&thr[i], NULL, helper, &args[i]);
+		}
+
+		/* Not produced until all parts are done. */
+		assert(ringbuf_consume(r, &off) == 0);
+		len = ringbuf_split_part(&sp, NHELPERS, &off);
+		memcpy(&rbuf[ret + off], src + off, len);
+		ringbuf_split_done(&sp);
+		ringbuf_split_wait(&sp);
+
+		len = ringbuf_consume(r, &off);
+		assert(len == RECLEN && off == (size_t)ret);
+		assert(memcmp(&rbuf[off], src, RECLEN) == 0);
+		ringbuf_release(r, len);
+
+		for (unsigned i = 0; i < NHELPERS; i++) {
+			pthread_join(thr[i], NULL);
+		}
+	}
+	free(r);
+}
+
+/*
+ * The state may be freed as soon as the wait returns, while the helpers
+ * are still running.
+ */
+static void
+test_wait_free(void)
+{
+	ringbuf_worker_t *w;
+	ringbuf_t *r;
+	size_t size;
+
+	ringbuf_get_sizes(MAX_WORKERS, &size, NULL);
+	r = malloc(size);
+	ringbuf_setup(r, MAX_WORKERS, RBUF_SIZE);
+	w = ringbuf_register(r, 0);
+
+	for (unsigned n = 0; n < 100; n++) {
+		ringbuf_split_t *sp = malloc(sizeof(ringbuf_split_t));
+		pthread_t thr[NHELPERS];
+		helper_arg_t args[NHELPERS];
+		size_t off, len;
+		ssize_t ret;
+
+		ret = ringbuf_acquire(r, w, RECLEN);
+		assert(ret != -1);
+		ringbuf_split_init(sp, r, w, RECLEN, NHELPERS);
+		for (unsigned i = 0; i < NHELPERS; i++) {
+			args[i].sp = sp;
+			args[i].dst = &rbuf[ret];
+			args[i].part = i;
+			pthread_create(&thr[i], NULL, helper, &args[i]);
+		}
+		ringbuf_split_wait(sp);
+		free(sp);
+
+		len = ringbuf_consume(r, &off);
+		assert(len == RECLEN && off == (size_t)ret);
+		ringbuf_release(r, len);
+		for (unsigned i = 0; i < NHELPERS; i++) {
+			pthread_join(thr[i], NULL);
+		}
+	}
+	free(r);
+}
+
+int
+main(void)
+{
+	test_parts();
+	test_fill();
+	test_wait_free();
+	puts("ok");
+	return 0;
+}
@@ -108,8 +108,8 @@ ringbuf_stress(void *arg)
 
 	/*
 	 * There are NCPU threads concurrently generating and producing
-	 * random messages and a single consumer thread (ID 0) verifying
-	 * and releasing the messages.
+	 * random messages, a single consumer thread (ID 0) verifying
+	 * and releasing the messages and a thread (ID 1) peeking at them.
 	 */
 
 	pthread_barrier_wait(&barrier);
@@ -135,6 +135,27 @@ ringbuf_stress(void *arg)
 			}
 			continue;
 		}
+		if (id == 1) {
+			unsigned char copy[RBUF_SIZE];
+			size_t rem, pos = 0;
+			uint64_t gen;
+
+			if ((rem = ringbuf_peek(ringbuf, &off, &gen)) == 0) {
+				continue;
+			}
+			assert(off + rem <= RBUF_SIZE);
+			memcpy(copy, &rbuf[off], rem);
+			if (ringbuf_peek_validate(ringbuf, gen) == -1) {
+				continue;
+			}
+			while (rem) {
+				ret = verify_message(&copy[pos]);
+				assert(ret > 0);
+				assert(ret <= (ssize_t)rem);
+				pos += ret, rem -= ret;
+			}
+			continue;
+		}
 		len = generate_message(buf, sizeof(buf) - 1);
 		if ((ret = ringbuf_acquire(ringbuf, w, len)) != -1) {
 			off = (size_t)ret;
@@ -165,7 +186,7 @@ run_test(void *func(void *))
 	/*
 	 * Setup the threads.
 	 */
-	nworkers = sysconf(_SC_NPROCESSORS_CONF) + 1;
+	nworkers = sysconf(_SC_NPROCESSORS_CONF) + 2;
 	thr = calloc(nworkers, sizeof(pthread_t));
 	pthread_barrier_init(&barrier, NULL, nworkers);
 	stop = false;
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2026 Mindaugas Rasiukevicius <rmind at noxt eu>
+ * All rights reserved.
+ *
+ * Use is subject to license terms, as specified in the LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "ringbuf_txn.h"
+
+#define	NRINGS		2
+#define	NSLOTS		2
+#define	NTXNS		20000
+
+static size_t		ringbuf_obj_size;
+static ringbuf_t *	rings[NRINGS];
+static uint64_t		bufs[NRINGS][64];
+static ringbuf_txn_t *	txn;
+
+static void
+setup(void)
+{
+	txn = malloc(ringbuf_txn_get_size(NSLOTS));
+	ringbuf_txn_setup(txn, NSLOTS);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		rings[i] = malloc(ringbuf_obj_size);
+		ringbuf_setup(rings[i], NSLOTS, sizeof(bufs[i]));
+	}
+}
+
+static void
+teardown(void)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		free(rings[i]);
+	}
+	free(txn);
+}
+
+static void
+init_recs(ringbuf_txn_rec_t *recs, unsigned slot, size_t len)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		recs[i] = (ringbuf_txn_rec_t){
+			.rbuf = rings[i], .w = ringbuf_register(rings[i], slot),
+			.buf = bufs[i], .len = len,
+		};
+	}
+}
+
+static void
+fill_recs(ringbuf_txn_rec_t *recs, uint32_t val)
+{
+	for (unsigned i = 0; i < NRINGS; i++) {
+		memcpy(ringbuf_frame_data(recs[i].frame), &val, sizeof(val));
+	}
+}
+
+/*
+ * next_val: return the value of the next record or -1 if none.
+ */
+static int64_t
+next_val(ringbuf_frame_iter_t *it)
+{
+	ringbuf_frame_t *f;
+	uint32_t val;
+
+	if (ringbuf_frame_consume(it, 0) == 0) {
+		return -1;
+	}
+	if ((f = ringbuf_frame_next(it)) == NULL) {
+		ringbuf_frame_release(it);
+		return -1;
+	}
+	memcpy(&val, ringbuf_frame_data(f), sizeof(val));
+	ringbuf_frame_release(it);
+	return val;
+}
+
+static void
+test_basic(void)
+{
+	ringbuf_txn_rec_t recs[NRINGS], other[NRINGS];
+	ringbuf_frame_iter_t its[NRINGS];
+	uint32_t offs[4];
+
+	setup();
+	init_recs(recs, 0, 4);
+	init_recs(other, 1, 4);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_frame_iter_init(&its[i], rings[i], bufs[i]);
+		ringbuf_frame_iter_settxn(&its[i], txn);
+	}
+
+	/* Not visible until committed, although produced. */
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == 0);
+	fill_recs(recs, 1);
+	assert(next_val(&its[0]) == -1);
+	ringbuf_txn_commit(txn, 0, recs, NRINGS);
+
+	/* The records of the open transaction block the others. */
+	assert(ringbuf_txn_acquire(txn, 1, other, NRINGS) == 0);
+	fill_recs(other, 2);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		ringbuf_frame_produce(other[i].rbuf, other[i].w,
+		    other[i].frame);
+	}
+	assert(next_val(&its[0]) == 1);
+	assert(next_val(&its[0]) == -1);
+	ringbuf_frame_consume(&its[1], 0);
+	assert(ringbuf_frame_index(&its[1], offs, 4) == 1);
+	ringbuf_frame_release(&its[1]);
+
+	/* The slot is reused once the consumers pass the records. */
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == 0);
+	fill_recs(recs, 3);
+	ringbuf_txn_abort(txn, 0, recs, NRINGS);
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == -1);
+	assert(errno == EBUSY);
+
+	/*
+	 * Commit the second transaction: the aborted records after
+	 * it are skipped in both rings.  Note: the state is set
+	 * directly, since the records were produced above.
+	 */
+	ringbuf_txn_commit(txn, 1, other, 0);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		assert(next_val(&its[i]) == 2);
+		assert(next_val(&its[i]) == -1);
+		assert(its[i].naborted == 1);
+	}
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == 0);
+	ringbuf_txn_abort(txn, 0, recs, NRINGS);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		assert(next_val(&its[i]) == -1);
+	}
+
+	/* No space in the second ring: the first record is aborted. */
+	recs[1].len = sizeof(bufs[1]) - 16;
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == -1);
+	assert(errno == ENOBUFS && recs[1].frame == NULL);
+	assert(next_val(&its[0]) == -1);
+	assert(its[0].naborted == 3);
+
+	teardown();
+}
+
+static void
+test_release(void)
+{
+	static const ringbuf_frame_opts_t opts = { .crc = true };
+	ringbuf_txn_rec_t recs[NRINGS];
+	ringbuf_frame_iter_t its[NRINGS];
+	ringbuf_frame_t *f;
+	uint8_t *p;
+
+	setup();
+	init_recs(recs, 0, 4);
+	for (unsigned i = 0; i < NRINGS; i++) {
+		recs[i].opts = &opts;
+		ringbuf_frame_iter_init(&its[i], rings[i], bufs[i]);
+		ringbuf_frame_iter_settxn(&its[i], txn);
+	}
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == 0);
+	fill_recs(recs, 1);
+	ringbuf_txn_commit(txn, 0, recs, NRINGS);
+
+	/* Restarting the iteration does not pass the record again. */
+	for (unsigned i = 0; i < 2; i++) {
+		assert(ringbuf_frame_consume(&its[0], 0) > 0);
+		f = ringbuf_frame_next(&its[0]);
+		assert(f != NULL);
+	}
+	ringbuf_frame_release(&its[0]);
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == -1);
+	assert(errno == EBUSY);
+
+	/* The corrupt record is skipped, but still passed on release. */
+	assert(ringbuf_frame_consume(&its[1], 0) > 0);
+	p = ringbuf_frame_data(recs[1].frame);
+	p[0] ^= 1;
+	assert(ringbuf_frame_next(&its[1]) == NULL);
+	assert(its[1].ncorrupt == 1);
+	ringbuf_frame_release(&its[1]);
+	assert(ringbuf_txn_acquire(txn, 0, recs, NRINGS) == 0);
+	ringbuf_txn_abort(txn, 0, recs, NRINGS);
+
+	teardown();
+}
+
+static void *
+producer(void *arg)
+{
+	const unsigned slot = (uintptr_t)arg;
+	ringbuf_txn_rec_t recs[NRINGS];
+	unsigned n = 0;
+
+	init_recs(recs, slot, 4);
+	while (n < NTXNS) {
+		if (ringbuf_txn_acquire(txn, slot, recs, NRINGS) == -1) {
+			sched_yield();
+			continue;
+		}
+		fill_recs(recs, n * NSLOTS + slot);
+		if (n % 3 == 2) {
+			ringbuf_txn_abort(txn, slot, recs, NRINGS);
+		} else {
+			ringbuf_txn_commit(txn, slot, recs, NRINGS);
+		}
+		n++;
+	}
+	return NULL;
+}
+
+typedef struct {
+	unsigned	ring;
+	uint64_t	sum;
+	unsigned	count;
+} consumer_arg_t;
+
+static void *
+consumer(void *arg)
+{
+	consumer_arg_t *ca = arg;
+	const unsigned expected = NSLOTS * (NTXNS - NTXNS / 3);
+	ringbuf_frame_iter_t it;
+
+	ringbuf_frame_iter_init(&it, rings[ca->ring], bufs[ca->ring]);
+	ringbuf_frame_iter_settxn(&it, txn);
+	while (ca->count < expected) {
+		ringbuf_frame_t *f;
+
+		if (ringbuf_frame_consume(&it, 0) == 0) {
+			sched_yield();
+			continue;
+		}
+		while ((f = ringbuf_frame_next(&it)) != NULL) {
+			uint32_t val;
+
+			memcpy(&val, ringbuf_frame_data(f), sizeof(val));
+			assert((val / NSLOTS) % 3 != 2);
+			ca->sum += val;
+			ca->count++;
+		}
+		ringbuf_frame_release(&it);
+	}
+	return NULL;
+}
+
+static void
+test_concurrent(void)
+{
+	pthread_t pthr[NSLOTS], cthr[NRINGS];
+	consumer_arg_t args[NRINGS];
+
+	setup();
+	for (unsigned i = 0; i < NRINGS; i++) {
+		args[i] = (consumer_arg_t){ .ring = i };
+		pthread_create(&cthr[i], NULL, consumer, &args[i]);
+	}
+	for (unsigned i = 0; i < NSLOTS; i++) {
+		pthread_create(&pthr[i], NULL, producer, (void *)(uintptr_t)i);
+	}
+	for (unsigned i = 0; i < NSLOTS; i++) {
+		pthread_join(pthr[i], NULL);
+	}
+	for (unsigned i = 0; i < NRINGS; i++) {
+		pthread_join(cthr[i], NULL);
+	}
+
+	/* Both rings have the same committed records. */
+	assert(args[0].count == args[1].count);
+	assert(args[0].sum == args[1].sum);
+	teardown();
+}
+
+int
+main(void)
+{
+	ringbuf_get_sizes(NSLOTS, &ringbuf_obj_size, NULL);
+	test_basic();
+	test_release();
+	test_concurrent();
+	puts("ok");
+	return 0;
+}
@@ -58,6 +58,17 @@
 #define	MAX(x, y)	((x) > (y) ? (x) : (y))
 #endif
 
+#ifndef roundup2
+#define	roundup2(x, m)	(((x) + ((m) - 1)) & ~((m) - 1))
+#endif
+
+/*
+ * Cache line size, used for padding the shared structures.
+ */
+#ifndef CACHE_LINE_SIZE
+#define	CACHE_LINE_SIZE		64
+#endif
+
 /*
  * Branch prediction macros.
  */
@@ -83,6 +94,7 @@
 #define	memory_order_relaxed	__ATOMIC_RELAXED
 #define	memory_order_acquire	__ATOMIC_ACQUIRE
 #define	memory_order_release	__ATOMIC_RELEASE
+#define	memory_order_acq_rel	__ATOMIC_ACQ_REL
 #define	memory_order_seq_cst	__ATOMIC_SEQ_CST
 #define	atomic_thread_fence(m)	__atomic_thread_fence(m)
 #endif
@@ -92,6 +104,12 @@
 #ifndef atomic_load_explicit
 #define	atomic_load_explicit	__atomic_load_n
 #endif
+#ifndef atomic_fetch_add_explicit
+#define	atomic_fetch_add_explicit	__atomic_fetch_add
+#endif
+#ifndef atomic_fetch_sub_explicit
+#define	atomic_fetch_sub_explicit	__atomic_fetch_sub
+#endif
 
 /*
  * Exponential back-off for the spinning paths.
@@ -112,4 +130,42 @@ do {								\
 		(count) += (count);				\
 } while (/* CONSTCOND */ 0);
 
+/*
+ * Wait/wake on a 32-bit word.  On Linux, use futex(2) (not private, so
+ * that it would work across the processes in the shared memory); on the
+ * other systems, fall back to yielding the CPU.
+ */
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static inline void
+futex_wait(volatile uint32_t *addr, uint32_t val)
+{
+	(void)syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static inline void
+futex_wake(volatile uint32_t *addr, int nwake)
+{
+	(void)syscall(SYS_futex, addr, FUTEX_WAKE, nwake, NULL, NULL, 0);
+}
+#else
+#include <sched.h>
+
+static inline void
+futex_wait(volatile uint32_t *addr, uint32_t val)
+{
+	if (atomic_load_explicit(addr, memory_order_relaxed) == val)
+		sched_yield();
+}
+
+static inline void
+futex_wake(volatile uint32_t *addr, int nwake)
+{
+	(void)addr; (void)nwake;
+}
+#endif
+
 #endif